@@ -0,0 +1,169 @@
+/**
+ * @file	capture_file.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_CAPTURE_FILE_H__
+#define __JCU_TRANSPORT_CAPTURE_FILE_H__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jcu {
+    namespace transport {
+        enum CaptureEventType {
+            CAPTURE_CONNECT = 1,
+            CAPTURE_CLOSE = 2,
+            CAPTURE_END = 3,
+            CAPTURE_READ = 4,
+            CAPTURE_WRITE = 5,
+            CAPTURE_KEYLOG = 6 // one NSS key log line (SSLKEYLOGFILE format)
+        };
+
+        enum CaptureRecordFlags {
+            CAPTURE_FLAG_TRUNCATED = 0x0001 // payload shorter than length
+        };
+
+        /**
+         * Memory-mapped capture of transport events.
+         * Records are appended without locks: a writer reserves its slot with an atomic add
+         * and publishes it by storing the record size last, so transports on any thread can
+         * share one file. Records that do not fit in the capacity are dropped and counted.
+         */
+        class CaptureFile {
+        public:
+#pragma pack(push, 1)
+            struct FileHeader {
+                char magic[8];
+                uint32_t version;
+                uint32_t header_size;
+                uint64_t start_time_us; // system clock, microseconds since epoch
+                uint64_t used_size;     // set by close(), 0 if the process did not close the file
+                uint32_t max_payload;
+                uint32_t reserved;
+            };
+
+            struct RecordHeader {
+                uint32_t size; // whole record with padding, 0 for a slot not published yet
+                uint16_t type;
+                uint16_t flags;
+                uint32_t connection_id;
+                uint32_t length;
+                uint64_t timestamp_ns; // since start_time_us, steady clock
+            };
+#pragma pack(pop)
+
+            static const char MAGIC[8];
+            static const uint32_t VERSION = 1;
+
+        private:
+            std::string path_;
+            uint64_t capacity_;
+            uint32_t sample_every_;
+            uint32_t max_payload_;
+
+            char *base_;
+#if defined(_WIN32)
+            void *file_handle_;
+            void *mapping_handle_;
+#else
+            int fd_;
+#endif
+
+            std::chrono::steady_clock::time_point start_;
+            std::atomic<uint64_t> tail_;
+            std::atomic<uint64_t> dropped_;
+            std::atomic<uint32_t> connections_;
+
+            CaptureFile();
+
+            bool map();
+
+        public:
+            /**
+             * @param capacity    file size, fixed while capturing
+             * @param sample_every capture one connection out of sample_every
+             * @param max_payload bytes of payload kept per read/write event, 0 for sizes only
+             * @return nullptr if the file could not be created or mapped
+             */
+            static std::shared_ptr<CaptureFile> create(const std::string &path, uint64_t capacity,
+                                                       uint32_t sample_every = 1, uint32_t max_payload = 0);
+
+            virtual ~CaptureFile();
+
+            /**
+             * Sampling decision for a new connection.
+             * @return connection id to record with, 0 if the connection is not captured
+             */
+            uint32_t sample();
+
+            /**
+             * Appends an event. Read and write payloads are cut to max_payload.
+             * @return false if the record was dropped
+             */
+            bool record(uint32_t connection_id, CaptureEventType type, const char *data, size_t length);
+
+            uint64_t getDropped() const;
+
+            /**
+             * Unmaps the file and truncates it to the recorded size.
+             * No transport may record anymore.
+             */
+            void close();
+        };
+
+        /**
+         * Reads a capture file back, up to the first record that was never published.
+         */
+        class CaptureReader {
+        public:
+            struct Record {
+                CaptureEventType type;
+                uint16_t flags;
+                uint32_t connection_id;
+                uint32_t length;
+                uint64_t timestamp_ns;
+                const char *payload;
+                uint32_t payload_length;
+            };
+
+        private:
+            std::vector<char> data_;
+            std::vector<Record> records_;
+            CaptureFile::FileHeader header_;
+
+            CaptureReader();
+
+        public:
+            /**
+             * @return nullptr if the file cannot be read or is not a capture
+             */
+            static std::shared_ptr<CaptureReader> open(const std::string &path);
+
+            const CaptureFile::FileHeader &getHeader() const;
+            const std::vector<Record> &getRecords() const;
+
+            /**
+             * Ids of all captured connections, in order of first appearance
+             */
+            std::vector<uint32_t> getConnections() const;
+
+            /**
+             * Writes the captured TLS secrets as an SSLKEYLOGFILE, for decrypting the
+             * captured ciphertext with e.g. Wireshark.
+             */
+            bool exportKeyLog(const std::string &path) const;
+        };
+    }
+}
+
+#endif // __JCU_TRANSPORT_CAPTURE_FILE_H__
@@ -0,0 +1,69 @@
+/**
+ * @file	capture_transport.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_CAPTURE_TRANSPORT_H__
+#define __JCU_TRANSPORT_CAPTURE_TRANSPORT_H__
+
+#include "transport.h"
+#include "capture_file.h"
+
+namespace jcu {
+    namespace transport {
+        /**
+         * Records the events of the transport it wraps into a CaptureFile, with the same
+         * chunking the layer above sees.
+         * Wrapped around a TcpTransport under a TlsTransport it records the ciphertext as
+         * it reaches SslEngine::SocketContext::feedRead(); wrapped around the TlsTransport
+         * it records plaintext.
+         */
+        class CaptureTransport : public Transport, private Transport::Handler {
+        private:
+            std::weak_ptr<CaptureTransport> self_;
+
+            std::shared_ptr<Transport> transport_;
+            std::shared_ptr<CaptureFile> capture_;
+            // 0 when the connection was not sampled
+            uint32_t connection_id_;
+
+            CaptureTransport(std::shared_ptr<uvw::Loop> loop);
+
+            void onTransportConnect(Transport &transport) override;
+            void onTransportClose(Transport &transport) override;
+            void onTransportError(Transport &transport, Error &err) override;
+            bool onTransportEnd(Transport &transport) override;
+            void onTransportData(Transport &transport, std::unique_ptr<char[]> data, size_t length) override;
+
+        public:
+            static std::shared_ptr<CaptureTransport> create(std::shared_ptr<uvw::Loop> loop, std::shared_ptr<Transport> transport, std::shared_ptr<CaptureFile> capture);
+
+            virtual ~CaptureTransport();
+
+            uint32_t getConnectionId() const;
+            const std::shared_ptr<CaptureFile> &getCaptureFile() const;
+
+            using Transport::connect;
+            void connect(Transport::Handler *handler) override;
+            void reconnect() override;
+            void disconnect() override;
+            void cleanup() override;
+            void closeConnection() override;
+
+            void setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) override;
+
+            void write(std::unique_ptr<char[]> data, size_t length) override;
+
+            void pauseRead() override;
+            void resumeRead() override;
+
+            uint32_t getCaptureId() const override;
+        };
+    }
+}
+
+#endif //__JCU_TRANSPORT_CAPTURE_TRANSPORT_H__
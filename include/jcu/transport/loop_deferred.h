@@ -0,0 +1,57 @@
+/**
+ * @file	loop_deferred.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_LOOP_DEFERRED_H__
+#define __JCU_TRANSPORT_LOOP_DEFERRED_H__
+
+#include <uvw/loop.hpp>
+#include <uvw/check.hpp>
+#include <uvw/idle.hpp>
+
+#include <memory>
+#include <functional>
+
+namespace jcu {
+    namespace transport {
+        /**
+         * Runs a callback once per loop iteration when scheduled, after the poll phase,
+         * so work requested several times within an iteration is done in one go.
+         * The check handle runs the callback, the idle handle keeps the loop from
+         * blocking in poll when schedule() was called outside of it.
+         */
+        class LoopDeferred {
+        private:
+            std::shared_ptr<uvw::Loop> loop_;
+            std::function<void()> callback_;
+
+            // created by the first schedule()
+            std::shared_ptr<uvw::CheckHandle> check_;
+            std::shared_ptr<uvw::IdleHandle> idle_;
+            bool pending_;
+
+        public:
+            LoopDeferred(std::shared_ptr<uvw::Loop> loop, const std::function<void()> &callback);
+            ~LoopDeferred();
+
+            LoopDeferred(const LoopDeferred&) = delete;
+            LoopDeferred &operator=(const LoopDeferred&) = delete;
+
+            void schedule();
+
+            /**
+             * For callers doing the work right away
+             */
+            void cancel();
+
+            bool isPending() const;
+        };
+    }
+}
+
+#endif //__JCU_TRANSPORT_LOOP_DEFERRED_H__
@@ -0,0 +1,121 @@
+/**
+ * @file	mbedtls_ssl_engine.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_MBEDTLS_SSL_ENGINE_H__
+#define __JCU_TRANSPORT_MBEDTLS_SSL_ENGINE_H__
+
+#include <jcu/transport/config.h>
+
+#include "ssl_engine.h"
+
+#ifdef JCU_TRANSPORT_HAS_MBEDTLS
+
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+namespace jcu {
+    namespace transport {
+        /**
+         * SslEngine backed by mbed TLS, for stream transports.
+         * The per-connection footprint is mostly the record buffers, whose size is fixed at
+         * mbed TLS build time (MBEDTLS_SSL_IN_CONTENT_LEN / MBEDTLS_SSL_OUT_CONTENT_LEN).
+         */
+        class MbedtlsSslEngine : public SslEngine {
+        public:
+            class MbedtlsSocketContext : public SslEngine::SocketContext {
+            public:
+                MbedtlsSocketContext();
+                virtual ~MbedtlsSocketContext();
+
+                void handshake() override;
+                void disconnect() override;
+
+                void write(std::unique_ptr<char[]> data, size_t length) override;
+                int feedRead(std::unique_ptr<char[]> data, size_t length) override;
+
+                /**
+                 * Server name used for SNI and certificate verification, only effective
+                 * before handshake(). See MbedtlsSslEngine::setHostname() for contexts
+                 * created by a TlsTransport.
+                 */
+                int setHostname(const char *hostname);
+
+                mbedtls_ssl_context *getMbedtlsSslContext();
+
+            private:
+                static int sendCallback(void *ctx, const unsigned char *buf, size_t len);
+                static int recvCallback(void *ctx, unsigned char *buf, size_t len);
+
+                int doHandshake();
+                int doRead();
+                int doWrite(const char *data, size_t length);
+                void handleShutdown();
+                void raiseError(int code, const char *name);
+
+                bool handshake_done_;
+                bool closed_;
+
+                // ciphertext received from the transport and not consumed by mbed TLS yet
+                std::vector<unsigned char> in_buf_;
+                size_t in_offset_;
+
+                // plaintext written before the handshake completed
+                std::list<std::pair<std::unique_ptr<char[]>, size_t>> pending_writes_;
+
+            public:
+                std::weak_ptr<MbedtlsSocketContext> self_;
+                std::weak_ptr<Transport> transport_;
+                // ssl_ points at the configuration, random generator and credentials of the engine
+                std::shared_ptr<MbedtlsSslEngine> engine_;
+
+                mbedtls_ssl_context ssl_;
+            };
+
+        private:
+            std::weak_ptr<MbedtlsSslEngine> self_;
+
+            mbedtls_ssl_config conf_;
+            mbedtls_entropy_context entropy_;
+            mbedtls_ctr_drbg_context ctr_drbg_;
+            std::string hostname_;
+
+            MbedtlsSslEngine();
+
+        public:
+            virtual ~MbedtlsSslEngine();
+
+            /**
+             * @param endpoint MBEDTLS_SSL_IS_CLIENT or MBEDTLS_SSL_IS_SERVER
+             * @return nullptr if the configuration or the random generator could not be set up
+             */
+            static std::shared_ptr<MbedtlsSslEngine> create(int endpoint = MBEDTLS_SSL_IS_CLIENT);
+            using SslEngine::createContext;
+            std::shared_ptr<SocketContext> createContext(std::shared_ptr<Transport> transport,
+                                                         Handler *handler) override;
+
+            mbedtls_ssl_config *getMbedtlsSslConfig();
+
+            /**
+             * Server name used for SNI and certificate verification by contexts created
+             * afterwards. Since mbed TLS 3.6.3 a client with MBEDTLS_SSL_VERIFY_REQUIRED
+             * fails the handshake without one.
+             */
+            void setHostname(const std::string &hostname);
+        };
+    }
+}
+
+#endif // JCU_TRANSPORT_HAS_MBEDTLS
+
+#endif //__JCU_TRANSPORT_MBEDTLS_SSL_ENGINE_H__
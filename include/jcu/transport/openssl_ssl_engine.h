@@ -13,17 +13,44 @@
 #include <jcu/transport/config.h>
 
 #include "ssl_engine.h"
+#include "capture_file.h"
 
 #ifdef JCU_TRANSPORT_HAS_OPENSSL
 
 #include <openssl/ssl.h>
 
-#include <deque>
+#include <uvw/timer.hpp>
+
+#include <list>
+#include <vector>
+#include <chrono>
 
 namespace jcu {
     namespace transport {
         class OpensslSslEngine : public SslEngine {
         public:
+            /**
+             * Dynamic TLS record sizing.
+             * Records start at about one MSS so the peer can decrypt the first bytes without
+             * waiting for a full 16KB record, then grow to max_record_size once
+             * boost_threshold bytes have been sent. The sizing resets after idle_timeout_ms
+             * without writes.
+             */
+            struct RecordSizing {
+                bool enabled = true;
+                size_t initial_record_size = 1400;
+                size_t max_record_size = 16 * 1024;
+                size_t boost_threshold = 1024 * 1024;
+                uint64_t idle_timeout_ms = 1000;
+                // merge writes issued in the same loop iteration into shared records
+                bool coalesce = true;
+            };
+
+        private:
+            class FlushScheduler;
+
+        public:
+
             class OpensslSocketContext : public SslEngine::SocketContext {
             private:
                 enum OpType {
@@ -47,16 +74,61 @@ namespace jcu {
 
                 int sendPending();
 
+                void compact() override;
+
+                void setRecordSizing(const RecordSizing &record_sizing);
+                void flushWrites();
+
+            private:
+                friend class FlushScheduler;
+
+                struct PendingWrite {
+                    std::unique_ptr<char[]> data;
+                    size_t length;
+                    size_t offset;
+                };
+
+                bool attachBio();
+                bool releaseBio();
+                void releaseIdleBuffers();
+
+                bool scheduleFlush();
+                void cancelFlush();
+                size_t nextRecordSize() const;
+
+                int sendDatagrams(std::unique_ptr<char[]> buf, int length);
+                void armDtlsTimer();
+
+                RecordSizing record_sizing_;
+                std::list<PendingWrite> pending_writes_;
+                std::vector<char> record_buf_;
+                uint64_t bytes_since_idle_;
+                std::chrono::steady_clock::time_point last_write_time_;
+
+                // shared by all contexts of the loop, held while a flush is pending
+                std::shared_ptr<FlushScheduler> flush_scheduler_;
+                bool flush_scheduled_;
+                // a write failed for good, later writes are dropped
+                bool write_failed_;
+
+                // DTLS: records are packed into datagrams of at most datagram_mtu_ bytes
+                bool datagram_;
+                int datagram_mtu_;
+                std::shared_ptr<uvw::TimerHandle> dtls_timer_;
+
+                // nesting depth of feedRead()/flushWrites()
+                int busy_;
+
+            public:
+                void setDatagramMtu(int mtu);
+
+                bool idle_compaction_;
+                size_t bio_buffer_size_;
+
                 std::weak_ptr<OpensslSocketContext> self_;
                 std::weak_ptr<Transport> transport_;
 
-                HandshakeCallback_t handshake_callback_;
-                WriteCallback_t write_callback_;
-                ReadCallback_t read_callback_;
-                CloseCallback_t close_callback_;
-                ErrorCallback_t error_callback_;
-
-                //Our BIO, all IO should be through this
+                //Our BIO, all IO should be through this (allocated on first use)
                 BIO     *app_bio_;
                 SSL     *ssl_;
 
@@ -65,17 +137,60 @@ namespace jcu {
 
         private:
             SSL_CTX *ssl_ctx_;
+            bool server_;
+            RecordSizing record_sizing_;
+            int datagram_mtu_;
+            bool idle_compaction_;
+            size_t bio_buffer_size_;
+            std::shared_ptr<CaptureFile> key_log_;
+
+            static void keyLogCallback(const SSL *ssl, const char *line);
 
         public:
-            static std::shared_ptr<OpensslSslEngine> create(const SSL_METHOD *meth);
+            /**
+             * meth may be a DTLS method (e.g. DTLS_method()) to secure a datagram
+             * transport such as UdpTransport.
+             * @param server contexts accept the handshake of the peer instead of initiating one
+             */
+            static std::shared_ptr<OpensslSslEngine> create(const SSL_METHOD *meth, bool server = false);
+            using SslEngine::createContext;
             std::shared_ptr<SocketContext> createContext(std::shared_ptr<Transport> transport,
-                                                         HandshakeCallback_t handshake_callback,
-                                                         WriteCallback_t write_callback,
-                                                         ReadCallback_t read_callback,
-                                                         CloseCallback_t close_callback,
-                                                         ErrorCallback_t error_callback) override;
+                                                         Handler *handler) override;
 
             SSL_CTX *getOpensslSslCtx();
+
+            /**
+             * Default record sizing for contexts created afterwards
+             */
+            void setRecordSizing(const RecordSizing &record_sizing);
+            const RecordSizing &getRecordSizing() const;
+
+            /**
+             * Largest datagram produced by DTLS contexts, without IP/UDP headers
+             */
+            void setDatagramMtu(int mtu);
+
+            /**
+             * Idle compaction for long-lived, mostly idle connections.
+             * OpenSSL releases its record buffers (SSL_MODE_RELEASE_BUFFERS) and the BIO pair
+             * is freed whenever both directions are drained, then allocated again on the next I/O.
+             */
+            void setIdleCompaction(bool enabled);
+
+            /**
+             * Buffer size of each half of the BIO pair, 0 for OpenSSL's default (17KB).
+             * Records larger than the buffer are passed through in several steps.
+             */
+            void setBioBufferSize(size_t size);
+
+            /**
+             * Records the session secrets of every context as CAPTURE_KEYLOG events, tagged
+             * with the capture id of the context (set by TlsTransport from the
+             * CaptureTransport it runs over, through any layers in between).
+             * CaptureReader::exportKeyLog() turns them into an SSLKEYLOGFILE.
+             * @return false if OpenSSL is older than 1.1.1
+             */
+            bool setKeyLog(std::shared_ptr<CaptureFile> capture);
         };
     }
 }
@@ -0,0 +1,127 @@
+/**
+ * @file	rate_limiter.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_RATE_LIMITER_H__
+#define __JCU_TRANSPORT_RATE_LIMITER_H__
+
+#include <stdint.h>
+
+#include <memory>
+#include <chrono>
+
+namespace jcu {
+    namespace transport {
+        /**
+         * Token bucket in bytes.
+         * A send may overdraw the bucket, so messages larger than the burst still pass;
+         * the debt delays the following sends.
+         */
+        class TokenBucket {
+        private:
+            uint64_t rate_;  // bytes per second, 0 is unlimited
+            uint64_t burst_;
+            double tokens_;
+            std::chrono::steady_clock::time_point updated_at_;
+
+        public:
+            TokenBucket(uint64_t rate = 0, uint64_t burst = 0);
+
+            /**
+             * @param burst 0 for one second worth of rate
+             */
+            void setRate(uint64_t rate, uint64_t burst = 0);
+            uint64_t getRate() const;
+
+            bool isLimited() const;
+
+            /**
+             * true while the bucket is not in debt
+             */
+            bool available(std::chrono::steady_clock::time_point now);
+            void consume(size_t bytes, std::chrono::steady_clock::time_point now);
+
+            /**
+             * Time until available() becomes true
+             */
+            std::chrono::steady_clock::duration waitTime(std::chrono::steady_clock::time_point now);
+
+        private:
+            void refill(std::chrono::steady_clock::time_point now);
+        };
+
+        /**
+         * Exponentially weighted moving average of a byte rate, with a time constant
+         * of tau_ms.
+         */
+        class RateMeter {
+        private:
+            double tau_;
+            double rate_;
+            std::chrono::steady_clock::time_point updated_at_;
+
+            void decay(std::chrono::steady_clock::time_point now);
+
+        public:
+            RateMeter(uint64_t tau_ms = 1000);
+
+            void add(size_t bytes, std::chrono::steady_clock::time_point now);
+
+            /**
+             * @return bytes per second
+             */
+            double getRate(std::chrono::steady_clock::time_point now);
+        };
+
+        /**
+         * Limits shared by a set of transports, nested under an optional parent
+         * (e.g. per tenant under a per-process limit). A transport may send only when its
+         * own bucket and the bucket of every enclosing group have tokens.
+         * Groups are not thread safe: share one only between transports of the same loop.
+         */
+        class ShapingGroup {
+        public:
+            enum Direction {
+                DIRECTION_WRITE = 0,
+                DIRECTION_READ = 1
+            };
+
+        private:
+            std::shared_ptr<ShapingGroup> parent_;
+            TokenBucket buckets_[2];
+            RateMeter meters_[2];
+
+            ShapingGroup(std::shared_ptr<ShapingGroup> parent);
+
+        public:
+            static std::shared_ptr<ShapingGroup> create(std::shared_ptr<ShapingGroup> parent = nullptr);
+
+            const std::shared_ptr<ShapingGroup> &getParent() const;
+
+            /**
+             * @param rate  bytes per second, 0 is unlimited
+             * @param burst 0 for one second worth of rate
+             */
+            void setWriteRate(uint64_t rate, uint64_t burst = 0);
+            void setReadRate(uint64_t rate, uint64_t burst = 0);
+
+            /**
+             * Measured rates in bytes per second, including all nested groups
+             */
+            double getWriteRate();
+            double getReadRate();
+
+            // whole chain, this group up to the root
+            bool available(Direction direction, std::chrono::steady_clock::time_point now);
+            void consume(Direction direction, size_t bytes, std::chrono::steady_clock::time_point now);
+            std::chrono::steady_clock::duration waitTime(Direction direction, std::chrono::steady_clock::time_point now);
+        };
+    }
+}
+
+#endif // __JCU_TRANSPORT_RATE_LIMITER_H__
@@ -0,0 +1,105 @@
+/**
+ * @file	reconnect_policy.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_RECONNECT_POLICY_H__
+#define __JCU_TRANSPORT_RECONNECT_POLICY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <mutex>
+#include <chrono>
+
+namespace jcu {
+    namespace transport {
+        /**
+         * Circuit breaker shared by every transport connecting to the same endpoint.
+         * After failure_threshold consecutive connect failures it opens and rejects
+         * attempts for open_duration_ms, then lets a single probe through (half-open).
+         */
+        class CircuitBreaker {
+        public:
+            enum State {
+                STATE_CLOSED,
+                STATE_OPEN,
+                STATE_HALF_OPEN
+            };
+
+        private:
+            std::mutex mutex_;
+            int failure_threshold_;
+            std::chrono::milliseconds open_duration_;
+
+            State state_;
+            int consecutive_failures_;
+            bool probe_in_flight_;
+            std::chrono::steady_clock::time_point opened_at_;
+
+            CircuitBreaker(int failure_threshold, uint64_t open_duration_ms);
+
+        public:
+            static std::shared_ptr<CircuitBreaker> create(int failure_threshold, uint64_t open_duration_ms);
+
+            /**
+             * Returns the breaker registered for endpoint, creating it if no transport holds one.
+             */
+            static std::shared_ptr<CircuitBreaker> forEndpoint(const std::string &endpoint, int failure_threshold, uint64_t open_duration_ms);
+
+            /**
+             * Ask for permission to start a connection attempt.
+             * @return 0 if the attempt may start now, otherwise milliseconds to wait
+             */
+            uint64_t acquire();
+            void recordSuccess();
+            void recordFailure();
+
+            /**
+             * Ends an acquired attempt that produced no connect result (e.g. the user
+             * disconnected meanwhile), so the next attempt may probe the endpoint.
+             */
+            void release();
+
+            State getState();
+        };
+
+        struct ReconnectPolicy {
+            bool enabled = false;
+
+            // decorrelated jitter: delay = min(max_delay_ms, random(base_delay_ms, previous_delay * 3))
+            uint64_t base_delay_ms = 100;
+            uint64_t max_delay_ms = 30000;
+
+            // 0 is unlimited
+            int max_attempts = 0;
+
+            // used when circuit_breaker is nullptr, a failure_threshold of 0 disables the breaker
+            int failure_threshold = 5;
+            uint64_t open_duration_ms = 10000;
+
+            // nullptr: share a breaker with all transports to the same remote endpoint
+            std::shared_ptr<CircuitBreaker> circuit_breaker;
+
+            // bytes written while disconnected that are held for the next connection,
+            // writes beyond it fail with UV_ENOBUFS. 0 is unlimited
+            size_t max_queued_bytes = 4 * 1024 * 1024;
+        };
+
+        enum ReconnectState {
+            RECONNECT_CONNECTING,
+            RECONNECT_CONNECTED,
+            RECONNECT_BACKOFF,
+            RECONNECT_CIRCUIT_OPEN,
+            RECONNECT_GAVE_UP
+        };
+    }
+}
+
+#endif // __JCU_TRANSPORT_RECONNECT_POLICY_H__
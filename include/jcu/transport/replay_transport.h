@@ -0,0 +1,95 @@
+/**
+ * @file	replay_transport.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_REPLAY_TRANSPORT_H__
+#define __JCU_TRANSPORT_REPLAY_TRANSPORT_H__
+
+#include "transport.h"
+#include "capture_file.h"
+
+#include <uvw/timer.hpp>
+
+#include <vector>
+
+namespace jcu {
+    namespace transport {
+        /**
+         * Plays one captured connection back to the layers stacked on it.
+         * Connect, read, end and close events are delivered with the recorded chunking, at
+         * the recorded pace or as fast as the loop runs. Reads whose payload was not
+         * captured are replayed as zeros of the recorded size. Writes go nowhere and are
+         * only counted.
+         * A TLS session cannot be replayed from its ciphertext, replay a capture taken
+         * above the TlsTransport to drive the application.
+         */
+        class ReplayTransport : public Transport {
+        public:
+            enum Speed {
+                REPLAY_RECORDED_SPEED,
+                REPLAY_MAX_SPEED
+            };
+
+        private:
+            std::weak_ptr<ReplayTransport> self_;
+
+            std::shared_ptr<CaptureReader> reader_;
+            uint32_t connection_id_;
+            Speed speed_;
+
+            std::vector<const CaptureReader::Record*> events_;
+            size_t next_;
+            uint64_t base_timestamp_ns_;
+            std::chrono::steady_clock::time_point started_at_;
+            std::shared_ptr<uvw::TimerHandle> timer_;
+
+            bool connected_;
+            bool closing_;
+            bool read_paused_;
+
+            uint64_t bytes_written_;
+            uint64_t write_count_;
+
+            ReplayTransport(std::shared_ptr<uvw::Loop> loop);
+
+            void scheduleNext();
+            void replayNext();
+
+        public:
+            static std::shared_ptr<ReplayTransport> create(std::shared_ptr<uvw::Loop> loop, std::shared_ptr<CaptureReader> reader, uint32_t connection_id, Speed speed = REPLAY_RECORDED_SPEED);
+
+            virtual ~ReplayTransport();
+
+            using Transport::connect;
+            void connect(Handler *handler) override;
+            // starts the playback over
+            void reconnect() override;
+            void disconnect() override;
+            void cleanup() override;
+
+            // the playback does not fail, the policy is ignored
+            void setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) override;
+
+            void write(std::unique_ptr<char[]> data, size_t length) override;
+
+            // holds the playback, the recorded pace resumes from the next event
+            void pauseRead() override;
+            void resumeRead() override;
+
+            /**
+             * true once every captured event was delivered
+             */
+            bool isFinished() const;
+
+            uint64_t getBytesWritten() const;
+            uint64_t getWriteCount() const;
+        };
+    }
+}
+
+#endif //__JCU_TRANSPORT_REPLAY_TRANSPORT_H__
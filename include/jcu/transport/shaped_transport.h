@@ -0,0 +1,181 @@
+/**
+ * @file	shaped_transport.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_SHAPED_TRANSPORT_H__
+#define __JCU_TRANSPORT_SHAPED_TRANSPORT_H__
+
+#include "transport.h"
+#include "rate_limiter.h"
+#include "loop_deferred.h"
+
+#include <uvw/timer.hpp>
+
+#include <list>
+
+namespace jcu {
+    namespace transport {
+        class ShapedTransport;
+
+        /**
+         * Serves the backlog of every ShapedTransport on one loop with deficit round robin:
+         * every backlogged transport gets quantum * weight bytes of credit per round and
+         * moves to the back of the order once it is spent, so a bulk upload cannot starve
+         * interactive connections sharing a ShapingGroup.
+         * Passes run once per loop iteration after new writes, and from a single timer
+         * while transports wait for tokens.
+         */
+        class ShapingScheduler {
+        private:
+            friend class ShapedTransport;
+
+            std::weak_ptr<ShapingScheduler> self_;
+
+            std::shared_ptr<uvw::Loop> loop_;
+            LoopDeferred deferred_;
+            std::shared_ptr<uvw::TimerHandle> timer_;
+            bool running_;
+
+            size_t quantum_;
+
+            // transports with queued writes, nullptr for entries removed during a pass
+            std::list<ShapedTransport*> active_;
+            // transports whose reading is paused for lack of tokens
+            std::list<ShapedTransport*> throttled_;
+
+            RateMeter write_meter_;
+            RateMeter read_meter_;
+
+            ShapingScheduler(std::shared_ptr<uvw::Loop> loop);
+
+            void activate(ShapedTransport *transport);
+            void throttle(ShapedTransport *transport);
+            void remove(ShapedTransport *transport);
+            void schedule();
+            void run();
+
+        public:
+            /**
+             * Returns the scheduler of loop, creating it if no transport holds one.
+             */
+            static std::shared_ptr<ShapingScheduler> forLoop(std::shared_ptr<uvw::Loop> loop);
+
+            virtual ~ShapingScheduler();
+
+            /**
+             * Bytes credited per round to a transport of weight 1 (default 16KB)
+             */
+            void setQuantum(size_t quantum);
+
+            /**
+             * Measured rates of all shaped transports on the loop, in bytes per second
+             */
+            double getWriteRate();
+            double getReadRate();
+
+            size_t getBackloggedCount() const;
+        };
+
+        /**
+         * Shapes the transport it wraps: its own token buckets for each direction, the
+         * limits of an optional ShapingGroup hierarchy, and fair scheduling of the writes
+         * that have to wait. Writes pass straight through while nothing is backlogged on
+         * the loop. Reading is paused on the wrapped transport while the read bucket is in
+         * debt, which bounds the inbound rate through TCP flow control.
+         */
+        class ShapedTransport : public Transport, private Transport::Handler {
+        private:
+            friend class ShapingScheduler;
+
+            std::weak_ptr<ShapedTransport> self_;
+
+            std::shared_ptr<Transport> transport_;
+            std::shared_ptr<ShapingScheduler> scheduler_;
+            std::shared_ptr<ShapingGroup> group_;
+
+            TokenBucket write_bucket_;
+            TokenBucket read_bucket_;
+            RateMeter write_meter_;
+            RateMeter read_meter_;
+            uint32_t weight_;
+
+            std::list<std::pair<std::unique_ptr<char[]>, size_t>> write_queue_;
+            size_t queued_bytes_;
+            size_t deficit_;
+            bool credited_; // got the quantum of the current round
+            bool write_active_;
+
+            bool read_throttled_; // paused by the shaper
+            bool read_paused_;    // paused by the user
+
+            ShapedTransport(std::shared_ptr<uvw::Loop> loop);
+
+            bool canWrite(std::chrono::steady_clock::time_point now);
+            bool canRead(std::chrono::steady_clock::time_point now);
+            std::chrono::steady_clock::duration writeWaitTime(std::chrono::steady_clock::time_point now);
+            std::chrono::steady_clock::duration readWaitTime(std::chrono::steady_clock::time_point now);
+            void send(std::unique_ptr<char[]> data, size_t length, std::chrono::steady_clock::time_point now);
+            void unthrottle();
+
+            void onTransportConnect(Transport &transport) override;
+            void onTransportClose(Transport &transport) override;
+            void onTransportError(Transport &transport, Error &err) override;
+            bool onTransportEnd(Transport &transport) override;
+            void onTransportData(Transport &transport, std::unique_ptr<char[]> data, size_t length) override;
+
+        public:
+            /**
+             * @param group nullptr for limits of this transport only
+             */
+            static std::shared_ptr<ShapedTransport> create(std::shared_ptr<uvw::Loop> loop, std::shared_ptr<Transport> transport, std::shared_ptr<ShapingGroup> group = nullptr);
+
+            virtual ~ShapedTransport();
+
+            /**
+             * @param rate  bytes per second, 0 is unlimited
+             * @param burst 0 for one second worth of rate
+             */
+            void setWriteRate(uint64_t rate, uint64_t burst = 0);
+            void setReadRate(uint64_t rate, uint64_t burst = 0);
+
+            /**
+             * Share of the scheduler rounds relative to other backlogged transports
+             */
+            void setWeight(uint32_t weight);
+
+            /**
+             * Measured rates in bytes per second
+             */
+            double getWriteRate();
+            double getReadRate();
+
+            /**
+             * Bytes written but held back by the shaper
+             */
+            size_t getQueuedBytes() const;
+
+            using Transport::connect;
+            void connect(Transport::Handler *handler) override;
+            void reconnect() override;
+            void disconnect() override;
+            void cleanup() override;
+            void closeConnection() override;
+
+            void setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) override;
+
+            void write(std::unique_ptr<char[]> data, size_t length) override;
+
+            void pauseRead() override;
+            void resumeRead() override;
+
+            uint32_t getCaptureId() const override;
+        };
+    }
+}
+
+#endif //__JCU_TRANSPORT_SHAPED_TRANSPORT_H__
@@ -0,0 +1,56 @@
+/**
+ * @file	shared_registry.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_SHARED_REGISTRY_H__
+#define __JCU_TRANSPORT_SHARED_REGISTRY_H__
+
+#include <memory>
+#include <mutex>
+#include <map>
+
+namespace jcu {
+    namespace transport {
+        /**
+         * Instances shared by key (e.g. one per loop) and owned by their users only:
+         * an entry lives as long as someone holds the shared_ptr returned by get().
+         */
+        template<typename Key, typename T>
+        class SharedRegistry {
+        private:
+            std::mutex mutex_;
+            std::map<Key, std::weak_ptr<T>> entries_;
+
+        public:
+            /**
+             * Returns the instance registered for key, or registers factory() if no one
+             * holds it anymore. Entries of released instances are dropped meanwhile.
+             */
+            template<typename Factory>
+            std::shared_ptr<T> get(const Key &key, Factory factory) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::weak_ptr<T> &entry = entries_[key];
+                std::shared_ptr<T> instance = entry.lock();
+                if(!instance) {
+                    for(typename std::map<Key, std::weak_ptr<T>>::iterator iter = entries_.begin(); iter != entries_.end(); ) {
+                        if(iter->second.expired() && (iter->first != key)) {
+                            iter = entries_.erase(iter);
+                        } else {
+                            ++iter;
+                        }
+                    }
+                    instance = factory();
+                    entry = instance;
+                }
+                return instance;
+            }
+        };
+    }
+}
+
+#endif //__JCU_TRANSPORT_SHARED_REGISTRY_H__
@@ -32,6 +32,20 @@ namespace jcu {
             typedef std::function<void(SocketContext *ssl_socket_ctx, int status)> CloseCallback_t;
             typedef std::function<void(SocketContext *ssl_socket_ctx, Error& err)> ErrorCallback_t;
 
+            /**
+             * All events of a socket context, as one object per connection
+             */
+            class Handler {
+            public:
+                virtual ~Handler() {}
+
+                virtual void onSslHandshake(SocketContext *ssl_socket_ctx, int status) = 0;
+                virtual void onSslWrite(SocketContext *ssl_socket_ctx, int status) {}
+                virtual void onSslRead(SocketContext *ssl_socket_ctx, const char *buf, int size) = 0;
+                virtual void onSslClose(SocketContext *ssl_socket_ctx, int status) = 0;
+                virtual void onSslError(SocketContext *ssl_socket_ctx, Error& err) = 0;
+            };
+
             class SocketContext {
             public:
                 virtual ~SocketContext() {};
@@ -41,20 +55,99 @@ namespace jcu {
 
                 virtual void write(std::unique_ptr<char[]> data, size_t length) = 0;
                 virtual int feedRead(std::unique_ptr<char[]> data, size_t length) = 0;
+
+                /**
+                 * Release buffers that are not needed while the connection is idle
+                 */
+                virtual void compact() {}
+
+                /**
+                 * Connection id the session is recorded under (see Transport::getCaptureId()),
+                 * used to tag its key log lines
+                 */
+                void setCaptureId(uint32_t capture_id) {
+                    capture_id_ = capture_id;
+                }
+                uint32_t getCaptureId() const {
+                    return capture_id_;
+                }
+
+                Handler *handler_ = nullptr;
+                uint32_t capture_id_ = 0;
+                // set when the context was created with std::function callbacks
+                std::unique_ptr<Handler> owned_handler_;
+            };
+
+        private:
+            class FunctionHandler : public Handler {
+            public:
+                HandshakeCallback_t handshake_callback_;
+                WriteCallback_t write_callback_;
+                ReadCallback_t read_callback_;
+                CloseCallback_t close_callback_;
+                ErrorCallback_t error_callback_;
+
+                void onSslHandshake(SocketContext *ssl_socket_ctx, int status) override {
+                    if(handshake_callback_) {
+                        handshake_callback_(ssl_socket_ctx, status);
+                    }
+                }
+                void onSslWrite(SocketContext *ssl_socket_ctx, int status) override {
+                    if(write_callback_) {
+                        write_callback_(ssl_socket_ctx, status);
+                    }
+                }
+                void onSslRead(SocketContext *ssl_socket_ctx, const char *buf, int size) override {
+                    if(read_callback_) {
+                        read_callback_(ssl_socket_ctx, buf, size);
+                    }
+                }
+                void onSslClose(SocketContext *ssl_socket_ctx, int status) override {
+                    if(close_callback_) {
+                        close_callback_(ssl_socket_ctx, status);
+                    }
+                }
+                void onSslError(SocketContext *ssl_socket_ctx, Error& err) override {
+                    if(error_callback_) {
+                        error_callback_(ssl_socket_ctx, err);
+                    }
+                }
             };
 
+        public:
+            virtual ~SslEngine() {}
+
             /**
              * per socket session.
+             * @param handler must outlive the context
              * @return
              */
             virtual std::shared_ptr<SocketContext> createContext(
+                std::shared_ptr<Transport> transport,
+                Handler *handler
+                ) = 0;
+
+            std::shared_ptr<SocketContext> createContext(
                 std::shared_ptr<Transport> transport,
                 HandshakeCallback_t handshake_callback,
                 WriteCallback_t write_callback,
                 ReadCallback_t read_callback,
                 CloseCallback_t close_callback,
                 ErrorCallback_t error_callback
-                ) = 0;
+                ) {
+                std::unique_ptr<FunctionHandler> handler(new FunctionHandler());
+                handler->handshake_callback_ = handshake_callback;
+                handler->write_callback_ = write_callback;
+                handler->read_callback_ = read_callback;
+                handler->close_callback_ = close_callback;
+                handler->error_callback_ = error_callback;
+
+                std::shared_ptr<SocketContext> ctx = createContext(transport, handler.get());
+                if(ctx) {
+                    ctx->owned_handler_ = std::move(handler);
+                }
+                return ctx;
+            }
         };
     }
 }
@@ -13,6 +13,10 @@
 #include <jcu/transport/transport.h>
 
 #include <uvw/tcp.hpp>
+#include <uvw/timer.hpp>
+
+#include <list>
+#include <random>
 
 namespace jcu {
     namespace transport {
@@ -20,19 +24,58 @@ namespace jcu {
         private:
             std::weak_ptr<TcpTransport> self_;
 
-            OnConnectCallback_t on_connect_;
-            OnCloseCallback_t on_close_;
-            OnErrorCallback_t on_error_;
-            OnEndCallback_t on_end_;
-            OnDataCallback_t on_data_;
+            enum HandleState {
+                HANDLE_CLOSED,
+                HANDLE_READY,  // initialized, not connected yet
+                HANDLE_OPEN,
+                HANDLE_CLOSING
+            };
+
+            // One handle per transport: after close it is re-initialized so the
+            // listeners registered in setupHandle() are reused across reconnects.
+            std::shared_ptr<uvw::TCPHandle> sock_handle_;
+            HandleState handle_state_;
+            bool reopen_on_close_;
 
-            std::weak_ptr<uvw::TCPHandle> sock_handle_;
+            bool has_data_connection_;
+            uvw::TCPHandle::Connection<uvw::DataEvent> data_connection_;
+            std::shared_ptr<void> data_handler_;
 
             std::string remote_ip_;
             int remote_port_;
 
+            bool connected_;
+            bool user_disconnect_;
+            bool read_paused_;
+            // written while a connection attempt is on its way, bounded by reconnect_policy_.max_queued_bytes
+            std::list<std::pair<std::unique_ptr<char[]>, size_t>> write_queue_;
+            size_t queued_bytes_;
+
+            ReconnectPolicy reconnect_policy_;
+            OnReconnectStateCallback_t on_reconnect_state_;
+            std::shared_ptr<CircuitBreaker> circuit_breaker_;
+            // an attempt allowed by circuit_breaker_ has no result yet
+            bool breaker_acquired_;
+            std::shared_ptr<uvw::TimerHandle> reconnect_timer_;
+            bool reconnect_pending_;
+            int reconnect_attempts_;
+            uint64_t reconnect_delay_ms_;
+            std::minstd_rand random_;
+
             TcpTransport(std::shared_ptr<uvw::Loop> loop);
 
+            std::shared_ptr<uvw::TCPHandle> prepareHandle();
+            void setupHandle();
+            void openHandle();
+            void closeHandle();
+            void attemptConnect();
+            void handleConnected();
+            void handleClosed(bool was_connected);
+            void notifyReconnectState(ReconnectState state, uint64_t delay_ms);
+            void releaseBreaker();
+            void clearWriteQueue();
+            void rejectWrite(int code);
+
         public:
             static std::shared_ptr<TcpTransport> create(std::shared_ptr<uvw::Loop> loop);
 
@@ -40,14 +83,40 @@ namespace jcu {
 
             void setRemote(const std::string& remote_ip, int remote_port);
 
-            void connect(const OnConnectCallback_t &on_connect, const OnCloseCallback_t &on_close, const OnErrorCallback_t& on_error) override;
+            using Transport::connect;
+            void connect(Handler *handler) override;
             void reconnect() override;
             void disconnect() override;
             void cleanup() override;
+            void closeConnection() override;
+
+            void setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) override;
 
             void onData(const OnDataCallback_t& callback) override;
-            void onEnd(const OnEndCallback_t& on_error) override;
             void write(std::unique_ptr<char[]> data, size_t length) override;
+
+            void pauseRead() override;
+            void resumeRead() override;
+
+            /**
+             * Statically typed alternative to onData().
+             * Handler::onData(TcpTransport&, std::unique_ptr<char[]>, size_t) is called straight
+             * from the uvw listener, so the data path has a single type-erased call and the
+             * handler body can be inlined. Replaces the data events of the connection handler.
+             */
+            template<class Handler>
+            void setDataHandler(const std::shared_ptr<Handler> &handler) {
+                std::shared_ptr<uvw::TCPHandle> sock_handle = prepareHandle();
+                Handler *handler_ptr = handler.get();
+                if(has_data_connection_) {
+                    sock_handle->erase(data_connection_);
+                }
+                data_handler_ = handler;
+                data_connection_ = sock_handle->on<uvw::DataEvent>([this, handler_ptr](uvw::DataEvent &evt, uvw::TCPHandle &handle) -> void {
+                    handler_ptr->onData(*this, std::move(evt.data), evt.length);
+                });
+                has_data_connection_ = true;
+            }
         };
     }
 }
@@ -14,37 +14,65 @@
 
 #include "ssl_engine.h"
 
+#include <list>
+
 namespace jcu {
     namespace transport {
-        class TlsTransport : public Transport {
+        class TlsTransport : public Transport, private Transport::Handler, private SslEngine::Handler {
         private:
             std::weak_ptr<TlsTransport> self_;
 
-            OnConnectCallback_t on_connect_;
-            OnCloseCallback_t on_close_;
-            OnErrorCallback_t on_error_;
-            OnEndCallback_t on_end_;
-            OnDataCallback_t on_data_;
-
             std::shared_ptr<Transport> transport_;
             std::shared_ptr<SslEngine> engine_;
             std::shared_ptr<SslEngine::SocketContext> ssl_socket_;
+            // the session is being closed by disconnect(), not by the peer
+            bool user_disconnect_;
+            // the current session finished its handshake, writes go to it directly
+            bool handshake_done_;
+
+            // plaintext written while no TLS session is established (e.g. while reconnecting)
+            std::list<std::pair<std::unique_ptr<char[]>, size_t>> write_queue_;
 
             TlsTransport(std::shared_ptr<uvw::Loop> loop);
 
+            // events of the inner transport
+            void onTransportConnect(Transport &transport) override;
+            void onTransportClose(Transport &transport) override;
+            void onTransportError(Transport &transport, Error &err) override;
+            bool onTransportEnd(Transport &transport) override;
+            void onTransportData(Transport &transport, std::unique_ptr<char[]> data, size_t length) override;
+
+            // events of the TLS session
+            void onSslHandshake(SslEngine::SocketContext *ssl_socket_ctx, int status) override;
+            void onSslRead(SslEngine::SocketContext *ssl_socket_ctx, const char *buf, int size) override;
+            void onSslClose(SslEngine::SocketContext *ssl_socket_ctx, int status) override;
+            void onSslError(SslEngine::SocketContext *ssl_socket_ctx, Error &err) override;
+
         public:
             static std::shared_ptr<TlsTransport> create(std::shared_ptr<uvw::Loop> loop, std::shared_ptr<Transport> transport, std::shared_ptr<SslEngine> engine);
 
             virtual ~TlsTransport();
 
-            void connect(const OnConnectCallback_t &on_connect, const OnCloseCallback_t &on_close, const OnErrorCallback_t& on_error) override;
+            using Transport::connect;
+            void connect(Transport::Handler *handler) override;
             void reconnect() override;
             void disconnect() override;
             void cleanup() override;
+            void closeConnection() override;
+
+            void setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) override;
 
-            void onData(const OnDataCallback_t& callback) override;
-            void onEnd(const OnEndCallback_t& on_error) override;
             void write(std::unique_ptr<char[]> data, size_t length) override;
+
+            void pauseRead() override;
+            void resumeRead() override;
+
+            uint32_t getCaptureId() const override;
+
+            /**
+             * Release the TLS session buffers of an idle connection
+             */
+            void compact();
         };
     }
 }
@@ -16,31 +16,158 @@
 #include <uvw/loop.hpp>
 
 #include "error.h"
+#include "reconnect_policy.h"
 
 namespace jcu {
     namespace transport {
         class Transport {
-        protected:
-            std::shared_ptr<uvw::Loop> loop_;
-
         public:
             typedef std::function<void(Transport &transport)> OnConnectCallback_t;
             typedef std::function<void(Transport &transport, std::unique_ptr<char[]> data, size_t length)> OnDataCallback_t;
             typedef std::function<void(Transport &transport)> OnCloseCallback_t;
             typedef std::function<void(Transport &transport, Error &err)> OnErrorCallback_t;
             typedef std::function<bool(Transport &transport)> OnEndCallback_t;
+            typedef std::function<void(Transport &transport, ReconnectState state, int attempt, uint64_t delay_ms)> OnReconnectStateCallback_t;
+
+            /**
+             * All events of a connection, as one object.
+             * Layers stacked on a transport (TlsTransport) implement this directly so that
+             * a connection keeps a single pointer instead of a set of std::function callbacks.
+             */
+            class Handler {
+            public:
+                virtual ~Handler() {}
+
+                virtual void onTransportConnect(Transport &transport) = 0;
+                virtual void onTransportClose(Transport &transport) = 0;
+                virtual void onTransportError(Transport &transport, Error &err) = 0;
+                // return true to keep the connection half-open
+                virtual bool onTransportEnd(Transport &transport) { return false; }
+                virtual void onTransportData(Transport &transport, std::unique_ptr<char[]> data, size_t length) = 0;
+            };
 
-            Transport(std::shared_ptr<uvw::Loop> loop) : loop_(loop) {}
+        private:
+            class FunctionHandler : public Handler {
+            public:
+                OnConnectCallback_t on_connect_;
+                OnCloseCallback_t on_close_;
+                OnErrorCallback_t on_error_;
+                OnEndCallback_t on_end_;
+                OnDataCallback_t on_data_;
+
+                void onTransportConnect(Transport &transport) override {
+                    if(on_connect_) {
+                        on_connect_(transport);
+                    }
+                }
+                void onTransportClose(Transport &transport) override {
+                    if(on_close_) {
+                        on_close_(transport);
+                    }
+                }
+                void onTransportError(Transport &transport, Error &err) override {
+                    if(on_error_) {
+                        on_error_(transport, err);
+                    }
+                }
+                bool onTransportEnd(Transport &transport) override {
+                    if(on_end_) {
+                        return on_end_(transport);
+                    }
+                    return false;
+                }
+                void onTransportData(Transport &transport, std::unique_ptr<char[]> data, size_t length) override {
+                    if(on_data_) {
+                        on_data_(transport, std::move(data), length);
+                    }
+                }
+            };
+
+            // only allocated when the std::function interface is used
+            std::unique_ptr<FunctionHandler> function_handler_;
+
+            FunctionHandler &functionHandler() {
+                if(!function_handler_) {
+                    function_handler_.reset(new FunctionHandler());
+                }
+                // never replaces a Handler given to connect(Handler*)
+                if(!handler_) {
+                    handler_ = function_handler_.get();
+                }
+                return *function_handler_;
+            }
+
+        protected:
+            std::shared_ptr<uvw::Loop> loop_;
+            Handler *handler_;
+
+        public:
+            Transport(std::shared_ptr<uvw::Loop> loop) : loop_(loop), handler_(nullptr) {}
             virtual ~Transport() {}
 
-            virtual void connect(const OnConnectCallback_t& on_connect, const OnCloseCallback_t& on_close, const OnErrorCallback_t& on_error) = 0;
+            std::shared_ptr<uvw::Loop> getLoop() const {
+                return loop_;
+            }
+
+            /**
+             * @param handler must outlive the connection, or be detached with cleanup()
+             */
+            virtual void connect(Handler *handler) = 0;
             virtual void reconnect() = 0;
             virtual void disconnect() = 0;
             virtual void cleanup() = 0; // remove callbacks (delete shared_ptr references)
 
-            virtual void onData(const OnDataCallback_t& callback) = 0;
-            virtual void onEnd(const OnEndCallback_t& callback) = 0;
+            /**
+             * Close the current connection as if the peer had dropped it, so the reconnect
+             * policy still applies. Used by layers that end the connection themselves
+             * (e.g. on a TLS close_notify).
+             */
+            virtual void closeConnection() {
+                disconnect();
+            }
+
+            /**
+             * Reconnect automatically when the connection is lost or a connect attempt fails.
+             * Writes issued while reconnecting are queued and sent once connected.
+             */
+            virtual void setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) = 0;
+
             virtual void write(std::unique_ptr<char[]> data, size_t length) = 0;
+
+            /**
+             * Stop / restart receiving, to bound the inbound rate.
+             * Data already read from the socket may still be delivered after pauseRead().
+             * The paused state persists across reconnects.
+             */
+            virtual void pauseRead() = 0;
+            virtual void resumeRead() = 0;
+
+            /**
+             * Connection id of the sampled CaptureTransport in this stack, 0 if none.
+             * Wrapping transports forward the id of the transport they wrap.
+             */
+            virtual uint32_t getCaptureId() const {
+                return 0;
+            }
+
+            virtual void connect(const OnConnectCallback_t& on_connect, const OnCloseCallback_t& on_close, const OnErrorCallback_t& on_error) {
+                FunctionHandler &handler = functionHandler();
+                handler.on_connect_ = on_connect;
+                handler.on_close_ = on_close;
+                handler.on_error_ = on_error;
+                connect(&handler);
+            }
+            /**
+             * Callbacks of the std::function interface. While a Handler given to
+             * connect(Handler*) is installed, that handler keeps receiving the events
+             * and these callbacks are not called.
+             */
+            virtual void onData(const OnDataCallback_t& callback) {
+                functionHandler().on_data_ = callback;
+            }
+            virtual void onEnd(const OnEndCallback_t& callback) {
+                functionHandler().on_end_ = callback;
+            }
         };
     }
 }
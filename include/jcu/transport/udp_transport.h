@@ -0,0 +1,87 @@
+/**
+ * @file	udp_transport.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_UDP_TRANSPORT_H__
+#define __JCU_TRANSPORT_UDP_TRANSPORT_H__
+
+#include <jcu/transport/transport.h>
+#include <jcu/transport/loop_deferred.h>
+
+#include <uvw/udp.hpp>
+
+#include <deque>
+
+namespace jcu {
+    namespace transport {
+        /**
+         * Datagram transport bound to a single remote endpoint.
+         * Every write() is sent as one datagram and every OnDataCallback_t call carries
+         * exactly one received datagram. Writes issued within one loop iteration are sent
+         * together with sendmmsg(), or as a single UDP GSO send when the kernel supports it
+         * (Linux only, other platforms send through uvw one by one).
+         * Datagrams written while no socket is open (before connect(), after disconnect())
+         * are held and sent by the next reconnect().
+         * An address that does not parse or a failed bind is reported with onTransportError(),
+         * followed by onTransportClose() instead of onTransportConnect() once a socket was opened.
+         */
+        class UdpTransport : public Transport {
+        private:
+            std::weak_ptr<UdpTransport> self_;
+
+            std::shared_ptr<uvw::UDPHandle> sock_handle_;
+
+            std::string remote_ip_;
+            int remote_port_;
+            std::string local_ip_;
+            int local_port_;
+            bool ipv6_;
+            bool read_paused_;
+
+            // resolved by reconnect()
+            sockaddr_storage remote_addr_;
+            unsigned char remote_key_[16];
+
+            std::deque<std::pair<std::unique_ptr<char[]>, size_t>> write_queue_;
+            LoopDeferred flush_;
+
+            struct BatchSender;
+            std::unique_ptr<BatchSender> batch_sender_;
+
+            UdpTransport(std::shared_ptr<uvw::Loop> loop);
+
+            void startRecv();
+            void closeSocket();
+            void flushWrites();
+
+        public:
+            static std::shared_ptr<UdpTransport> create(std::shared_ptr<uvw::Loop> loop);
+
+            virtual ~UdpTransport();
+
+            void setRemote(const std::string& remote_ip, int remote_port);
+            void setLocal(const std::string& local_ip, int local_port);
+
+            using Transport::connect;
+            void connect(Handler *handler) override;
+            void reconnect() override;
+            void disconnect() override;
+            void cleanup() override;
+
+            // datagrams have no connection to lose, the policy is ignored
+            void setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) override;
+
+            void write(std::unique_ptr<char[]> data, size_t length) override;
+
+            void pauseRead() override;
+            void resumeRead() override;
+        };
+    }
+}
+
+#endif //__JCU_TRANSPORT_UDP_TRANSPORT_H__
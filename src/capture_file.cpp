@@ -0,0 +1,294 @@
+/**
+ * @file	capture_file.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/capture_file.h>
+
+#include <string.h>
+
+#include <fstream>
+#include <iterator>
+#include <set>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+namespace jcu {
+    namespace transport {
+
+        const char CaptureFile::MAGIC[8] = {'J', 'C', 'U', 'C', 'A', 'P', 0, 0};
+
+        static inline uint64_t alignRecord(uint64_t size) {
+            return (size + 7) & ~((uint64_t)7);
+        }
+
+        std::shared_ptr<CaptureFile> CaptureFile::create(const std::string &path, uint64_t capacity,
+                                                         uint32_t sample_every, uint32_t max_payload) {
+            std::shared_ptr<CaptureFile> instance(new CaptureFile());
+            instance->path_ = path;
+            instance->capacity_ = capacity;
+            instance->sample_every_ = sample_every ? sample_every : 1;
+            instance->max_payload_ = max_payload;
+            if((capacity < sizeof(FileHeader)) || !instance->map()) {
+                return nullptr;
+            }
+
+            FileHeader *header = reinterpret_cast<FileHeader*>(instance->base_);
+            memcpy(header->magic, MAGIC, sizeof(MAGIC));
+            header->version = VERSION;
+            header->header_size = (uint32_t)alignRecord(sizeof(FileHeader));
+            header->start_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            header->used_size = 0;
+            header->max_payload = max_payload;
+            header->reserved = 0;
+
+            instance->start_ = std::chrono::steady_clock::now();
+            instance->tail_.store(header->header_size);
+            return instance;
+        }
+
+        CaptureFile::CaptureFile()
+            : capacity_(0), sample_every_(1), max_payload_(0), base_(NULL),
+#if defined(_WIN32)
+              file_handle_(INVALID_HANDLE_VALUE), mapping_handle_(NULL),
+#else
+              fd_(-1),
+#endif
+              tail_(0), dropped_(0), connections_(0) {
+        }
+
+        CaptureFile::~CaptureFile() {
+            close();
+        }
+
+        bool CaptureFile::map() {
+#if defined(_WIN32)
+            HANDLE file = CreateFileA(path_.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                                      CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+            if(file == INVALID_HANDLE_VALUE) {
+                return false;
+            }
+            file_handle_ = file;
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                                                (DWORD)(capacity_ >> 32), (DWORD)(capacity_ & 0xffffffff), NULL);
+            if(!mapping) {
+                return false;
+            }
+            mapping_handle_ = mapping;
+            base_ = (char *)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)capacity_);
+            return base_ != NULL;
+#else
+            fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if(fd_ < 0) {
+                return false;
+            }
+            if(ftruncate(fd_, (off_t)capacity_) != 0) {
+                return false;
+            }
+            void *base = mmap(NULL, (size_t)capacity_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if(base == MAP_FAILED) {
+                return false;
+            }
+            base_ = (char *)base;
+            return true;
+#endif
+        }
+
+        uint32_t CaptureFile::sample() {
+            uint32_t n = connections_.fetch_add(1, std::memory_order_relaxed);
+            if(n % sample_every_) {
+                return 0;
+            }
+            return n / sample_every_ + 1;
+        }
+
+        bool CaptureFile::record(uint32_t connection_id, CaptureEventType type, const char *data, size_t length) {
+            size_t captured = length;
+            if((type == CAPTURE_READ) || (type == CAPTURE_WRITE)) {
+                if(captured > max_payload_) {
+                    captured = max_payload_;
+                }
+            }
+
+            uint64_t size = alignRecord(sizeof(RecordHeader) + captured);
+            uint64_t offset = tail_.fetch_add(size, std::memory_order_relaxed);
+            if(!base_ || (offset + size > capacity_)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            RecordHeader *header = reinterpret_cast<RecordHeader*>(base_ + offset);
+            header->type = (uint16_t)type;
+            header->flags = (captured < length) ? CAPTURE_FLAG_TRUNCATED : 0;
+            header->connection_id = connection_id;
+            header->length = (uint32_t)length;
+            header->timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_).count();
+            if(captured) {
+                memcpy(base_ + offset + sizeof(RecordHeader), data, captured);
+            }
+
+            // publish: readers of a live mapping stop at the first zero size
+            reinterpret_cast<std::atomic<uint32_t>*>(&header->size)->store((uint32_t)size, std::memory_order_release);
+            return true;
+        }
+
+        uint64_t CaptureFile::getDropped() const {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+        void CaptureFile::close() {
+            if(!base_) {
+#if defined(_WIN32)
+                if(mapping_handle_) {
+                    CloseHandle((HANDLE)mapping_handle_);
+                    mapping_handle_ = NULL;
+                }
+                if(file_handle_ != INVALID_HANDLE_VALUE) {
+                    CloseHandle((HANDLE)file_handle_);
+                    file_handle_ = INVALID_HANDLE_VALUE;
+                }
+#else
+                if(fd_ >= 0) {
+                    ::close(fd_);
+                    fd_ = -1;
+                }
+#endif
+                return;
+            }
+
+            uint64_t used = tail_.load();
+            if(used > capacity_) {
+                // the last reservations may have been dropped, keep whole records only
+                used = reinterpret_cast<FileHeader*>(base_)->header_size;
+                while(used + sizeof(RecordHeader) <= capacity_) {
+                    uint32_t size = reinterpret_cast<RecordHeader*>(base_ + used)->size;
+                    if(!size || (used + size > capacity_)) {
+                        break;
+                    }
+                    used += size;
+                }
+            }
+            reinterpret_cast<FileHeader*>(base_)->used_size = used;
+
+#if defined(_WIN32)
+            UnmapViewOfFile(base_);
+            base_ = NULL;
+            CloseHandle((HANDLE)mapping_handle_);
+            mapping_handle_ = NULL;
+            LARGE_INTEGER end;
+            end.QuadPart = (LONGLONG)used;
+            SetFilePointerEx((HANDLE)file_handle_, end, NULL, FILE_BEGIN);
+            SetEndOfFile((HANDLE)file_handle_);
+            CloseHandle((HANDLE)file_handle_);
+            file_handle_ = INVALID_HANDLE_VALUE;
+#else
+            munmap(base_, (size_t)capacity_);
+            base_ = NULL;
+            if(ftruncate(fd_, (off_t)used) != 0) {
+                // the file keeps its full size, readers stop at used_size anyway
+            }
+            ::close(fd_);
+            fd_ = -1;
+#endif
+        }
+
+        std::shared_ptr<CaptureReader> CaptureReader::open(const std::string &path) {
+            std::shared_ptr<CaptureReader> instance(new CaptureReader());
+            std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+            if(!file) {
+                return nullptr;
+            }
+            instance->data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+            std::vector<char> &data = instance->data_;
+            if(data.size() < sizeof(CaptureFile::FileHeader)) {
+                return nullptr;
+            }
+            memcpy(&instance->header_, data.data(), sizeof(CaptureFile::FileHeader));
+            const CaptureFile::FileHeader &header = instance->header_;
+            if(memcmp(header.magic, CaptureFile::MAGIC, sizeof(CaptureFile::MAGIC)) ||
+               (header.version != CaptureFile::VERSION) || (header.header_size > data.size())) {
+                return nullptr;
+            }
+
+            uint64_t end = data.size();
+            if(header.used_size && (header.used_size < end)) {
+                end = header.used_size;
+            }
+            uint64_t offset = header.header_size;
+            while(offset + sizeof(CaptureFile::RecordHeader) <= end) {
+                CaptureFile::RecordHeader rh;
+                memcpy(&rh, &data[offset], sizeof(rh));
+                if((rh.size < sizeof(rh)) || (offset + rh.size > end)) {
+                    break;
+                }
+
+                Record record;
+                record.type = (CaptureEventType)rh.type;
+                record.flags = rh.flags;
+                record.connection_id = rh.connection_id;
+                record.length = rh.length;
+                record.timestamp_ns = rh.timestamp_ns;
+                record.payload = &data[offset + sizeof(rh)];
+                // the record size includes the padding, truncated payloads are max_payload long
+                record.payload_length = (rh.flags & CAPTURE_FLAG_TRUNCATED) ? header.max_payload : rh.length;
+                if(record.payload_length > rh.size - sizeof(rh)) {
+                    record.payload_length = (uint32_t)(rh.size - sizeof(rh));
+                }
+                instance->records_.push_back(record);
+
+                offset += rh.size;
+            }
+            return instance;
+        }
+
+        CaptureReader::CaptureReader() {
+            memset(&header_, 0, sizeof(header_));
+        }
+
+        const CaptureFile::FileHeader &CaptureReader::getHeader() const {
+            return header_;
+        }
+
+        const std::vector<CaptureReader::Record> &CaptureReader::getRecords() const {
+            return records_;
+        }
+
+        std::vector<uint32_t> CaptureReader::getConnections() const {
+            std::vector<uint32_t> connections;
+            std::set<uint32_t> seen;
+            for(std::vector<Record>::const_iterator iter = records_.begin(); iter != records_.end(); ++iter) {
+                if(iter->connection_id && seen.insert(iter->connection_id).second) {
+                    connections.push_back(iter->connection_id);
+                }
+            }
+            return connections;
+        }
+
+        bool CaptureReader::exportKeyLog(const std::string &path) const {
+            std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+            if(!file) {
+                return false;
+            }
+            for(std::vector<Record>::const_iterator iter = records_.begin(); iter != records_.end(); ++iter) {
+                if(iter->type == CAPTURE_KEYLOG) {
+                    file.write(iter->payload, iter->payload_length);
+                    file.put('\n');
+                }
+            }
+            return (bool)file;
+        }
+    }
+}
@@ -0,0 +1,124 @@
+/**
+ * @file	capture_transport.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/capture_transport.h>
+
+namespace jcu {
+    namespace transport {
+
+        std::shared_ptr<CaptureTransport> CaptureTransport::create(std::shared_ptr<uvw::Loop> loop, std::shared_ptr<Transport> transport, std::shared_ptr<CaptureFile> capture) {
+            std::shared_ptr<CaptureTransport> instance(new CaptureTransport(loop));
+            instance->self_ = instance;
+            instance->transport_ = transport;
+            instance->capture_ = capture;
+            if(capture) {
+                instance->connection_id_ = capture->sample();
+            }
+            return instance;
+        }
+
+        CaptureTransport::CaptureTransport(std::shared_ptr<uvw::Loop> loop) : Transport(loop), connection_id_(0) {
+
+        }
+
+        CaptureTransport::~CaptureTransport() {
+
+        }
+
+        uint32_t CaptureTransport::getConnectionId() const {
+            return connection_id_;
+        }
+
+        const std::shared_ptr<CaptureFile> &CaptureTransport::getCaptureFile() const {
+            return capture_;
+        }
+
+        uint32_t CaptureTransport::getCaptureId() const {
+            // an unsampled capture leaves the id of a capture further down
+            return connection_id_ ? connection_id_ : transport_->getCaptureId();
+        }
+
+        void CaptureTransport::connect(Transport::Handler *handler) {
+            handler_ = handler;
+            transport_->connect(static_cast<Transport::Handler*>(this));
+        }
+
+        void CaptureTransport::onTransportConnect(Transport &transport) {
+            if(connection_id_) {
+                capture_->record(connection_id_, CAPTURE_CONNECT, NULL, 0);
+            }
+            if(handler_) {
+                handler_->onTransportConnect(*this);
+            }
+        }
+        void CaptureTransport::onTransportClose(Transport &transport) {
+            if(connection_id_) {
+                capture_->record(connection_id_, CAPTURE_CLOSE, NULL, 0);
+            }
+            if(handler_) {
+                handler_->onTransportClose(*this);
+            }
+        }
+        void CaptureTransport::onTransportError(Transport &transport, Error &err) {
+            if(handler_) {
+                handler_->onTransportError(*this, err);
+            }
+        }
+        bool CaptureTransport::onTransportEnd(Transport &transport) {
+            if(connection_id_) {
+                capture_->record(connection_id_, CAPTURE_END, NULL, 0);
+            }
+            if(handler_) {
+                return handler_->onTransportEnd(*this);
+            }
+            return false;
+        }
+        void CaptureTransport::onTransportData(Transport &transport, std::unique_ptr<char[]> data, size_t length) {
+            if(connection_id_) {
+                capture_->record(connection_id_, CAPTURE_READ, data.get(), length);
+            }
+            if(handler_) {
+                handler_->onTransportData(*this, std::move(data), length);
+            }
+        }
+
+        void CaptureTransport::reconnect() {
+            transport_->reconnect();
+        }
+        void CaptureTransport::disconnect() {
+            transport_->disconnect();
+        }
+        void CaptureTransport::closeConnection() {
+            transport_->closeConnection();
+        }
+        void CaptureTransport::cleanup() {
+            transport_->cleanup();
+            handler_ = nullptr;
+        }
+        void CaptureTransport::setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) {
+            transport_->setReconnectPolicy(policy, [this, on_state](Transport& transport, ReconnectState state, int attempt, uint64_t delay_ms) -> void {
+                if(on_state) {
+                    on_state(*this, state, attempt, delay_ms);
+                }
+            });
+        }
+        void CaptureTransport::write(std::unique_ptr<char[]> data, size_t length) {
+            if(connection_id_) {
+                capture_->record(connection_id_, CAPTURE_WRITE, data.get(), length);
+            }
+            transport_->write(std::move(data), length);
+        }
+        void CaptureTransport::pauseRead() {
+            transport_->pauseRead();
+        }
+        void CaptureTransport::resumeRead() {
+            transport_->resumeRead();
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/**
+ * @file	loop_deferred.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/loop_deferred.h>
+
+namespace jcu {
+    namespace transport {
+
+        LoopDeferred::LoopDeferred(std::shared_ptr<uvw::Loop> loop, const std::function<void()> &callback)
+            : loop_(loop), callback_(callback), pending_(false) {
+        }
+
+        LoopDeferred::~LoopDeferred() {
+            if(check_) {
+                check_->close();
+                idle_->close();
+            }
+        }
+
+        void LoopDeferred::schedule() {
+            if(pending_) {
+                return;
+            }
+            if(!check_) {
+                check_ = loop_->resource<uvw::CheckHandle>();
+                check_->on<uvw::CheckEvent>([this](uvw::CheckEvent &evt, uvw::CheckHandle &handle) -> void {
+                    // the callback may schedule again, for the next iteration
+                    cancel();
+                    callback_();
+                });
+                idle_ = loop_->resource<uvw::IdleHandle>();
+            }
+            check_->start();
+            idle_->start();
+            pending_ = true;
+        }
+
+        void LoopDeferred::cancel() {
+            if(pending_) {
+                check_->stop();
+                idle_->stop();
+                pending_ = false;
+            }
+        }
+
+        bool LoopDeferred::isPending() const {
+            return pending_;
+        }
+    }
+}
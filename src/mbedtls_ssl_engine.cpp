@@ -0,0 +1,294 @@
+/**
+ * @file	mbedtls_ssl_engine.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/mbedtls_ssl_engine.h>
+
+#ifdef JCU_TRANSPORT_HAS_MBEDTLS
+
+#include <mbedtls/error.h>
+#include <mbedtls/version.h>
+
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+#include <psa/crypto.h>
+#endif
+
+#include <string.h>
+
+namespace jcu {
+    namespace transport {
+
+        class MbedtlsSslEngineError : public Error {
+        public:
+            int code_;
+            std::string name_;
+            std::string what_;
+
+            MbedtlsSslEngineError(int code, const std::string &name, const std::string &what)
+                : code_(code), name_(name), what_(what) {}
+
+            const char *what() const override {
+                return what_.c_str();
+            }
+            const char *name() const override {
+                return name_.c_str();
+            }
+            int code() const override {
+                return code_;
+            }
+            explicit operator bool() const override {
+                return true;
+            }
+        };
+
+        std::shared_ptr<MbedtlsSslEngine> MbedtlsSslEngine::create(int endpoint) {
+            static const char personalization[] = "jcu-transport";
+            std::shared_ptr<MbedtlsSslEngine> instance(new MbedtlsSslEngine());
+            instance->self_ = instance;
+
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+            if(psa_crypto_init() != PSA_SUCCESS) {
+                return nullptr;
+            }
+#endif
+
+            if(mbedtls_ctr_drbg_seed(&instance->ctr_drbg_, mbedtls_entropy_func, &instance->entropy_,
+                                     (const unsigned char *)personalization, sizeof(personalization) - 1) != 0) {
+                return nullptr;
+            }
+            if(mbedtls_ssl_config_defaults(&instance->conf_, endpoint, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+                return nullptr;
+            }
+            mbedtls_ssl_conf_rng(&instance->conf_, mbedtls_ctr_drbg_random, &instance->ctr_drbg_);
+            return instance;
+        }
+
+        MbedtlsSslEngine::MbedtlsSslEngine() {
+            mbedtls_ssl_config_init(&conf_);
+            mbedtls_entropy_init(&entropy_);
+            mbedtls_ctr_drbg_init(&ctr_drbg_);
+        }
+
+        MbedtlsSslEngine::~MbedtlsSslEngine() {
+            mbedtls_ssl_config_free(&conf_);
+            mbedtls_ctr_drbg_free(&ctr_drbg_);
+            mbedtls_entropy_free(&entropy_);
+        }
+
+        std::shared_ptr<SslEngine::SocketContext> MbedtlsSslEngine::createContext(
+            std::shared_ptr<Transport> transport,
+            Handler *handler
+        ) {
+            std::shared_ptr<MbedtlsSocketContext> ctx(new MbedtlsSocketContext());
+
+            ctx->self_ = ctx;
+            ctx->transport_ = transport;
+            ctx->engine_ = self_.lock();
+            ctx->handler_ = handler;
+
+            if(mbedtls_ssl_setup(&ctx->ssl_, &conf_) != 0) {
+                return nullptr;
+            }
+            if(!hostname_.empty() && (mbedtls_ssl_set_hostname(&ctx->ssl_, hostname_.c_str()) != 0)) {
+                return nullptr;
+            }
+            mbedtls_ssl_set_bio(&ctx->ssl_, ctx.get(), MbedtlsSocketContext::sendCallback, MbedtlsSocketContext::recvCallback, NULL);
+
+            return ctx;
+        }
+
+        mbedtls_ssl_config *MbedtlsSslEngine::getMbedtlsSslConfig() {
+            return &conf_;
+        }
+
+        void MbedtlsSslEngine::setHostname(const std::string &hostname) {
+            hostname_ = hostname;
+        }
+
+        MbedtlsSslEngine::MbedtlsSocketContext::MbedtlsSocketContext()
+            : handshake_done_(false), closed_(false), in_offset_(0) {
+            mbedtls_ssl_init(&ssl_);
+        }
+
+        MbedtlsSslEngine::MbedtlsSocketContext::~MbedtlsSocketContext() {
+            mbedtls_ssl_free(&ssl_);
+        }
+
+        int MbedtlsSslEngine::MbedtlsSocketContext::setHostname(const char *hostname) {
+            return mbedtls_ssl_set_hostname(&ssl_, hostname);
+        }
+
+        mbedtls_ssl_context *MbedtlsSslEngine::MbedtlsSocketContext::getMbedtlsSslContext() {
+            return &ssl_;
+        }
+
+        void MbedtlsSslEngine::MbedtlsSocketContext::handshake() {
+            doHandshake();
+        }
+
+        void MbedtlsSslEngine::MbedtlsSocketContext::disconnect() {
+            std::shared_ptr<MbedtlsSocketContext> self = self_.lock();
+            int r = mbedtls_ssl_close_notify(&ssl_);
+            closed_ = true;
+            if(handler_) {
+                handler_->onSslClose(this, (r == 0) ? 1 : r);
+            }
+        }
+
+        void MbedtlsSslEngine::MbedtlsSocketContext::write(std::unique_ptr<char[]> data, size_t length) {
+            if(!handshake_done_) {
+                pending_writes_.push_back(std::make_pair(std::move(data), length));
+                return;
+            }
+            doWrite(data.get(), length);
+        }
+
+        int MbedtlsSslEngine::MbedtlsSocketContext::feedRead(std::unique_ptr<char[]> data, size_t length) {
+            std::shared_ptr<MbedtlsSocketContext> self = self_.lock();
+
+            if(in_offset_) {
+                in_buf_.erase(in_buf_.begin(), in_buf_.begin() + in_offset_);
+                in_offset_ = 0;
+            }
+            in_buf_.insert(in_buf_.end(), (const unsigned char *)data.get(), (const unsigned char *)data.get() + length);
+
+            if(!handshake_done_) {
+                int r = doHandshake();
+                if(!handshake_done_) {
+                    return r;
+                }
+            }
+            return doRead();
+        }
+
+        int MbedtlsSslEngine::MbedtlsSocketContext::doHandshake() {
+            std::shared_ptr<MbedtlsSocketContext> self = self_.lock();
+
+            int r = mbedtls_ssl_handshake(&ssl_);
+            if(r == MBEDTLS_ERR_SSL_WANT_READ || r == MBEDTLS_ERR_SSL_WANT_WRITE) {
+                return 0;
+            }
+            if(r != 0) {
+                raiseError(r, "mbedtls_ssl_handshake");
+                if(handler_) {
+                    handler_->onSslHandshake(this, 0);
+                }
+                return -1;
+            }
+
+            handshake_done_ = true;
+            if(handler_) {
+                handler_->onSslHandshake(this, 1);
+            }
+            while(!pending_writes_.empty() && !closed_) {
+                std::pair<std::unique_ptr<char[]>, size_t> item = std::move(pending_writes_.front());
+                pending_writes_.pop_front();
+                doWrite(item.first.get(), item.second);
+            }
+            return 1;
+        }
+
+        int MbedtlsSslEngine::MbedtlsSocketContext::doRead() {
+            unsigned char tbuf[16*1024];
+            int r;
+
+            while(!closed_) {
+                r = mbedtls_ssl_read(&ssl_, tbuf, sizeof(tbuf));
+                if(r > 0) {
+                    if(handler_) {
+                        handler_->onSslRead(this, (const char *)tbuf, r);
+                    }
+                    continue;
+                }
+                if(r == MBEDTLS_ERR_SSL_WANT_READ || r == MBEDTLS_ERR_SSL_WANT_WRITE) {
+                    return 0;
+                }
+#ifdef MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET
+                if(r == MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET) {
+                    continue;
+                }
+#endif
+                if(r == 0 || r == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+                    handleShutdown();
+                    return 0;
+                }
+                raiseError(r, "mbedtls_ssl_read");
+                return r;
+            }
+            return 0;
+        }
+
+        int MbedtlsSslEngine::MbedtlsSocketContext::doWrite(const char *data, size_t length) {
+            std::shared_ptr<MbedtlsSocketContext> self = self_.lock();
+            size_t offset = 0;
+
+            // mbedtls_ssl_write() takes at most one record per call
+            while(offset < length) {
+                int r = mbedtls_ssl_write(&ssl_, (const unsigned char *)data + offset, length - offset);
+                if(r < 0) {
+                    raiseError(r, "mbedtls_ssl_write");
+                    return r;
+                }
+                offset += r;
+            }
+            if(handler_) {
+                handler_->onSslWrite(this, (int)length);
+            }
+            return (int)length;
+        }
+
+        void MbedtlsSslEngine::MbedtlsSocketContext::handleShutdown() {
+            if(closed_) {
+                return;
+            }
+            closed_ = true;
+            mbedtls_ssl_close_notify(&ssl_);
+            if(handler_) {
+                handler_->onSslClose(this, 1);
+            }
+        }
+
+        void MbedtlsSslEngine::MbedtlsSocketContext::raiseError(int code, const char *name) {
+            char what[256] = {0};
+            mbedtls_strerror(code, what, sizeof(what));
+            MbedtlsSslEngineError err(code, name, what);
+            if(handler_) {
+                handler_->onSslError(this, err);
+            }
+        }
+
+        int MbedtlsSslEngine::MbedtlsSocketContext::sendCallback(void *ctx, const unsigned char *buf, size_t len) {
+            MbedtlsSocketContext *self = static_cast<MbedtlsSocketContext*>(ctx);
+            std::shared_ptr<Transport> transport = self->transport_.lock();
+            if(!transport) {
+                return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+            }
+            std::unique_ptr<char[]> data(new char[len]);
+            memcpy(data.get(), buf, len);
+            transport->write(std::move(data), len);
+            return (int)len;
+        }
+
+        int MbedtlsSslEngine::MbedtlsSocketContext::recvCallback(void *ctx, unsigned char *buf, size_t len) {
+            MbedtlsSocketContext *self = static_cast<MbedtlsSocketContext*>(ctx);
+            size_t available = self->in_buf_.size() - self->in_offset_;
+            if(!available) {
+                return MBEDTLS_ERR_SSL_WANT_READ;
+            }
+            if(len > available) {
+                len = available;
+            }
+            memcpy(buf, &self->in_buf_[self->in_offset_], len);
+            self->in_offset_ += len;
+            return (int)len;
+        }
+
+    }
+}
+
+#endif // JCU_TRANSPORT_HAS_MBEDTLS
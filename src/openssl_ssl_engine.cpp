@@ -8,6 +8,12 @@
  */
 
 #include <jcu/transport/openssl_ssl_engine.h>
+#include <jcu/transport/loop_deferred.h>
+#include <jcu/transport/shared_registry.h>
+
+#include <string.h>
+
+#include <algorithm>
 
 namespace jcu {
     namespace transport {
@@ -35,39 +41,106 @@ namespace jcu {
             }
         };
 
-        std::shared_ptr<OpensslSslEngine> OpensslSslEngine::create(const SSL_METHOD *meth) {
+        // ex_data slots of the engine and the contexts, the app data stays free for the user
+        static int engineExIndex() {
+            static int index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+            return index;
+        }
+        static int contextExIndex() {
+            static int index = SSL_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+            return index;
+        }
+
+        /**
+         * Flushes the coalesced writes of every context on a loop once per iteration.
+         */
+        class OpensslSslEngine::FlushScheduler {
+        private:
+            std::weak_ptr<FlushScheduler> self_;
+
+            LoopDeferred deferred_;
+
+            std::list<std::weak_ptr<OpensslSocketContext>> dirty_;
+
+            FlushScheduler(std::shared_ptr<uvw::Loop> loop) : deferred_(loop, [this]() -> void { run(); }) {}
+
+        public:
+            static std::shared_ptr<FlushScheduler> forLoop(std::shared_ptr<uvw::Loop> loop) {
+                static SharedRegistry<uvw::Loop*, FlushScheduler> registry;
+                return registry.get(loop.get(), [&loop]() -> std::shared_ptr<FlushScheduler> {
+                    std::shared_ptr<FlushScheduler> instance(new FlushScheduler(loop));
+                    instance->self_ = instance;
+                    return instance;
+                });
+            }
+
+            void add(const std::shared_ptr<OpensslSocketContext> &ctx) {
+                dirty_.push_back(ctx);
+                deferred_.schedule();
+            }
+
+            void run() {
+                // the last context may release the scheduler while flushing
+                std::shared_ptr<FlushScheduler> self = self_.lock();
+                std::list<std::weak_ptr<OpensslSocketContext>> dirty;
+
+                // contexts written to while flushing go to the next iteration
+                dirty.swap(dirty_);
+                for(std::list<std::weak_ptr<OpensslSocketContext>>::iterator iter = dirty.begin(); iter != dirty.end(); ++iter) {
+                    std::shared_ptr<OpensslSocketContext> ctx = iter->lock();
+                    // cancelled contexts were flushed directly already
+                    if(ctx && ctx->flush_scheduled_) {
+                        ctx->flushWrites();
+                    }
+                }
+            }
+        };
+
+        std::shared_ptr<OpensslSslEngine> OpensslSslEngine::create(const SSL_METHOD *meth, bool server) {
             std::shared_ptr<OpensslSslEngine> instance(new OpensslSslEngine());
             instance->ssl_ctx_ = SSL_CTX_new(meth);
+            instance->server_ = server;
+            instance->datagram_mtu_ = 1200;
+            instance->idle_compaction_ = false;
+            instance->bio_buffer_size_ = 0;
             return instance;
         }
 
         std::shared_ptr<SslEngine::SocketContext> OpensslSslEngine::createContext(
             std::shared_ptr<Transport> transport,
-            HandshakeCallback_t handshake_callback,
-            WriteCallback_t write_callback,
-            ReadCallback_t read_callback,
-            CloseCallback_t close_callback,
-            ErrorCallback_t error_callback
+            Handler *handler
             ) {
-            int r;
             std::shared_ptr<OpensslSocketContext> ctx(new OpensslSocketContext());
 
             ctx->self_ = ctx;
             ctx->transport_ = transport;
-            ctx->handshake_callback_ = handshake_callback;
-            ctx->write_callback_ = write_callback;
-            ctx->read_callback_ = read_callback;
-            ctx->close_callback_ = close_callback;
-            ctx->error_callback_ = error_callback;
+            ctx->handler_ = handler;
+            ctx->setRecordSizing(record_sizing_);
+            ctx->idle_compaction_ = idle_compaction_;
+            ctx->bio_buffer_size_ = bio_buffer_size_;
 
             ctx->ssl_ = SSL_new(this->ssl_ctx_);
-
-            r = BIO_new_bio_pair(&ctx->ssl_bio_, 0, &ctx->app_bio_, 0);
-            if(r != 1) {
+            if(!ctx->ssl_) {
                 return nullptr;
             }
+            SSL_set_ex_data(ctx->ssl_, contextExIndex(), ctx.get());
+            if(server_) {
+                SSL_set_accept_state(ctx->ssl_);
+            } else {
+                SSL_set_connect_state(ctx->ssl_);
+            }
 
-            SSL_set_bio(ctx->ssl_, ctx->ssl_bio_, ctx->ssl_bio_);
+            // a small BIO pair may take a record in several steps
+            SSL_set_mode(ctx->ssl_, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+            if(idle_compaction_) {
+                SSL_set_mode(ctx->ssl_, SSL_MODE_RELEASE_BUFFERS);
+            }
+
+            if(SSL_is_dtls(ctx->ssl_)) {
+                // the BIO pair cannot report the path MTU
+                SSL_set_options(ctx->ssl_, SSL_OP_NO_QUERY_MTU);
+                ctx->setDatagramMtu(datagram_mtu_);
+            }
 
             return ctx;
         }
@@ -76,28 +149,290 @@ namespace jcu {
             return ssl_ctx_;
         }
 
-        OpensslSslEngine::OpensslSocketContext::OpensslSocketContext() {
+        void OpensslSslEngine::setRecordSizing(const RecordSizing &record_sizing) {
+            record_sizing_ = record_sizing;
+        }
+
+        const OpensslSslEngine::RecordSizing &OpensslSslEngine::getRecordSizing() const {
+            return record_sizing_;
+        }
+
+        void OpensslSslEngine::setDatagramMtu(int mtu) {
+            datagram_mtu_ = mtu;
+        }
+
+        void OpensslSslEngine::setIdleCompaction(bool enabled) {
+            idle_compaction_ = enabled;
+        }
+
+        void OpensslSslEngine::setBioBufferSize(size_t size) {
+            bio_buffer_size_ = size;
+        }
+
+        bool OpensslSslEngine::setKeyLog(std::shared_ptr<CaptureFile> capture) {
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+            key_log_ = capture;
+            SSL_CTX_set_ex_data(ssl_ctx_, engineExIndex(), this);
+            SSL_CTX_set_keylog_callback(ssl_ctx_, capture ? keyLogCallback : NULL);
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void OpensslSslEngine::keyLogCallback(const SSL *ssl, const char *line) {
+            OpensslSslEngine *engine = static_cast<OpensslSslEngine*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), engineExIndex()));
+            OpensslSocketContext *ctx = static_cast<OpensslSocketContext*>(SSL_get_ex_data(ssl, contextExIndex()));
+            if(!engine || !engine->key_log_) {
+                return;
+            }
+            engine->key_log_->record(ctx ? ctx->getCaptureId() : 0, CAPTURE_KEYLOG, line, strlen(line));
+        }
+
+        OpensslSslEngine::OpensslSocketContext::OpensslSocketContext()
+            : bytes_since_idle_(0), flush_scheduled_(false), write_failed_(false), datagram_(false), datagram_mtu_(0),
+              busy_(0), idle_compaction_(false), bio_buffer_size_(0) {
+            app_bio_ = NULL;
             ssl_ = NULL;
+            ssl_bio_ = NULL;
         }
 
         OpensslSslEngine::OpensslSocketContext::~OpensslSocketContext() {
+            if(dtls_timer_) {
+                dtls_timer_->close();
+                dtls_timer_ = nullptr;
+            }
             if(ssl_) {
+                // also frees ssl_bio_
                 SSL_free(ssl_);
                 ssl_ = NULL;
             }
+            if(app_bio_) {
+                BIO_free(app_bio_);
+                app_bio_ = NULL;
+            }
+        }
+
+        bool OpensslSslEngine::OpensslSocketContext::attachBio() {
+            if(app_bio_) {
+                return true;
+            }
+            if(BIO_new_bio_pair(&ssl_bio_, bio_buffer_size_, &app_bio_, bio_buffer_size_) != 1) {
+                OpensslSslEngineError err(0, "BIO_new_bio_pair", "BIO_new_bio_pair failed");
+                if(handler_) {
+                    handler_->onSslError(this, err);
+                }
+                return false;
+            }
+            SSL_set_bio(ssl_, ssl_bio_, ssl_bio_);
+            return true;
+        }
+
+        bool OpensslSslEngine::OpensslSocketContext::releaseBio() {
+            if(!app_bio_) {
+                return true;
+            }
+            if((BIO_ctrl_pending(app_bio_) > 0) || (BIO_ctrl_pending(ssl_bio_) > 0)) {
+                return false;
+            }
+            SSL_set_bio(ssl_, NULL, NULL);
+            BIO_free(app_bio_);
+            app_bio_ = NULL;
+            ssl_bio_ = NULL;
+            return true;
+        }
+
+        void OpensslSslEngine::OpensslSocketContext::releaseIdleBuffers() {
+            // never from inside feedRead()/flushWrites(), which still use the BIO pair
+            if(busy_ || !pending_writes_.empty()) {
+                return;
+            }
+            std::vector<char>().swap(record_buf_);
+            releaseBio();
+            // the loop handles go with the last context that holds the scheduler
+            if(!flush_scheduled_) {
+                flush_scheduler_ = nullptr;
+            }
+        }
+
+        void OpensslSslEngine::OpensslSocketContext::compact() {
+            std::shared_ptr<OpensslSocketContext> self = self_.lock();
+            releaseIdleBuffers();
         }
 
         void OpensslSslEngine::OpensslSocketContext::handshake() {
-            SSL_set_connect_state(ssl_);
+            if(!attachBio()) {
+                return;
+            }
             tlsOperation(OP_HANDSHAKE, NULL, 0);
         }
 
         void OpensslSslEngine::OpensslSocketContext::disconnect() {
+            std::shared_ptr<OpensslSocketContext> self = self_.lock();
+            if(!attachBio()) {
+                return;
+            }
+            // writes held back for coalescing go out ahead of the close_notify
+            if(!pending_writes_.empty()) {
+                cancelFlush();
+                flushWrites();
+            }
             tlsOperation(OP_SHUTDOWN, NULL, 0);
         }
 
         void OpensslSslEngine::OpensslSocketContext::write(std::unique_ptr<char[]> data, size_t length) {
-            tlsOperation(OP_WRITE, data.get(), length);
+            if(!length || write_failed_) {
+                return;
+            }
+            PendingWrite item;
+            item.data = std::move(data);
+            item.length = length;
+            item.offset = 0;
+            pending_writes_.push_back(std::move(item));
+
+            if(record_sizing_.coalesce && scheduleFlush()) {
+                return;
+            }
+            flushWrites();
+        }
+
+        void OpensslSslEngine::OpensslSocketContext::setRecordSizing(const RecordSizing &record_sizing) {
+            record_sizing_ = record_sizing;
+            if(record_sizing_.max_record_size > 16 * 1024) {
+                record_sizing_.max_record_size = 16 * 1024;
+            }
+            if(record_sizing_.initial_record_size > record_sizing_.max_record_size) {
+                record_sizing_.initial_record_size = record_sizing_.max_record_size;
+            }
+        }
+
+        void OpensslSslEngine::OpensslSocketContext::setDatagramMtu(int mtu) {
+            datagram_ = true;
+            datagram_mtu_ = mtu;
+            SSL_set_mtu(ssl_, mtu);
+
+            // one record, and so one datagram, per application write
+            record_sizing_.enabled = false;
+            record_sizing_.coalesce = false;
+        }
+
+        bool OpensslSslEngine::OpensslSocketContext::scheduleFlush() {
+            if(flush_scheduled_) {
+                return true;
+            }
+
+            std::shared_ptr<OpensslSocketContext> self = self_.lock();
+            if(!flush_scheduler_) {
+                std::shared_ptr<Transport> transport = transport_.lock();
+                std::shared_ptr<uvw::Loop> loop = transport ? transport->getLoop() : nullptr;
+                if(!loop || !self) {
+                    return false;
+                }
+                flush_scheduler_ = FlushScheduler::forLoop(loop);
+            }
+
+            flush_scheduler_->add(self);
+            flush_scheduled_ = true;
+            return true;
+        }
+
+        void OpensslSslEngine::OpensslSocketContext::cancelFlush() {
+            // the scheduler skips the stale entry
+            flush_scheduled_ = false;
+        }
+
+        size_t OpensslSslEngine::OpensslSocketContext::nextRecordSize() const {
+            if(!record_sizing_.enabled) {
+                // one record per application buffer
+                return 0;
+            }
+            if(bytes_since_idle_ < record_sizing_.boost_threshold) {
+                return record_sizing_.initial_record_size;
+            }
+            return record_sizing_.max_record_size;
+        }
+
+        void OpensslSslEngine::OpensslSocketContext::flushWrites() {
+            std::shared_ptr<OpensslSocketContext> self = self_.lock();
+
+            cancelFlush();
+
+            // Data written before the handshake completes is flushed from OP_HANDSHAKE
+            if(!ssl_ || !SSL_is_init_finished(ssl_) || !attachBio()) {
+                return;
+            }
+            busy_++;
+
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if(now - last_write_time_ >= std::chrono::milliseconds(record_sizing_.idle_timeout_ms)) {
+                bytes_since_idle_ = 0;
+            }
+
+            while(!pending_writes_.empty()) {
+                PendingWrite &front = pending_writes_.front();
+                size_t record_size = nextRecordSize();
+                size_t available = front.length - front.offset;
+                char *record_ptr;
+                size_t record_length;
+
+                if(!record_size || available >= record_size) {
+                    record_ptr = front.data.get() + front.offset;
+                    record_length = record_size ? record_size : available;
+                } else {
+                    // gather several small writes into a single record
+                    record_buf_.resize(record_size);
+                    record_length = 0;
+                    for(std::list<PendingWrite>::iterator iter = pending_writes_.begin();
+                        (iter != pending_writes_.end()) && (record_length < record_size); ++iter) {
+                        size_t part = std::min(iter->length - iter->offset, record_size - record_length);
+                        memcpy(&record_buf_[record_length], iter->data.get() + iter->offset, part);
+                        record_length += part;
+                    }
+                    record_ptr = &record_buf_[0];
+                }
+
+                int r = tlsOperation(OP_WRITE, record_ptr, (int)record_length);
+                if(r <= 0) {
+                    int err = (r < 0) ? SSL_get_error(ssl_, r) : SSL_ERROR_ZERO_RETURN;
+                    if((err == SSL_ERROR_WANT_WRITE) && (BIO_ctrl_get_write_guarantee(ssl_bio_) > 0)) {
+                        // tlsOperation drained the BIO pair, the record fits now
+                        continue;
+                    }
+                    if((err == SSL_ERROR_WANT_READ) || (err == SSL_ERROR_WANT_WRITE)) {
+                        // keep the remaining data, feedRead() flushes it again
+                        break;
+                    }
+                    // the session is closed or broken, nothing queued can be sent anymore
+                    write_failed_ = true;
+                    pending_writes_.clear();
+                    if(err != SSL_ERROR_ZERO_RETURN) {
+                        OpensslSslEngineError error(err, "SSL_write", "SSL_write failed");
+                        if(handler_) {
+                            handler_->onSslError(this, error);
+                        }
+                    }
+                    break;
+                }
+
+                size_t consumed = (size_t)r;
+                bytes_since_idle_ += consumed;
+                while(consumed > 0) {
+                    PendingWrite &item = pending_writes_.front();
+                    size_t part = std::min(item.length - item.offset, consumed);
+                    item.offset += part;
+                    consumed -= part;
+                    if(item.offset == item.length) {
+                        pending_writes_.pop_front();
+                    }
+                }
+            }
+
+            last_write_time_ = now;
+
+            busy_--;
+            if(idle_compaction_) {
+                releaseIdleBuffers();
+            }
         }
 
         int OpensslSslEngine::OpensslSocketContext::feedRead(std::unique_ptr<char[]> data, size_t length) {
@@ -107,11 +442,24 @@ namespace jcu {
 
             char *data_ptr = data.get();
 
+            if(!attachBio()) {
+                return -1;
+            }
+            busy_++;
+
             // assert( data != NULL && "invalid argument passed");
             // assert( sz > 0 && "Size of data should be positive");
             for( offset = 0; offset < length; offset += i ) {
-                //handle error condition
+                // a BIO pair smaller than the input takes it in several steps
                 i =  BIO_write(app_bio_, data_ptr + offset, length - offset);
+                if ( i <= 0 ) {
+                    OpensslSslEngineError err(i, "BIO_write", "BIO_write failed");
+                    if(handler_) {
+                        handler_->onSslError(this, err);
+                    }
+                    rv = -1;
+                    break;
+                }
 
                 //if handshake is not complete, do it again
                 if ( SSL_is_init_finished(ssl_) ) {
@@ -120,6 +468,15 @@ namespace jcu {
                     rv = tlsOperation(OP_HANDSHAKE, NULL, 0);
                 }
             }
+
+            busy_--;
+            if((rv >= 0) && !pending_writes_.empty() && !flush_scheduled_) {
+                // writes held back by SSL_ERROR_WANT_READ
+                flushWrites();
+            }
+            if(idle_compaction_) {
+                releaseIdleBuffers();
+            }
             return rv;
         }
         
@@ -133,39 +490,54 @@ namespace jcu {
 
             switch ( op ) {
                 case OP_HANDSHAKE: {
-                    r = SSL_do_handshake(ssl_);
-                    bytes = sendPending();
-                    if(bytes < 0) {
-                        OpensslSslEngineError err(bytes, "sendPending", "sendPending in OP_HANDSHAKE failed");
-                        if(error_callback_) {
-                            error_callback_(this, err);
+                    // a flight larger than the BIO pair (e.g. a long certificate chain)
+                    // is passed through in several steps
+                    for(;;) {
+                        r = SSL_do_handshake(ssl_);
+                        bytes = sendPending();
+                        if(bytes < 0) {
+                            OpensslSslEngineError err(bytes, "sendPending", "sendPending in OP_HANDSHAKE failed");
+                            if(handler_) {
+                                handler_->onSslError(this, err);
+                            }
+                            return -1;
                         }
-                        return -1;
+                        if((r < 0) && (bytes > 0) && (SSL_get_error(ssl_, r) == SSL_ERROR_WANT_WRITE) &&
+                           (BIO_ctrl_get_write_guarantee(ssl_bio_) > 0)) {
+                            continue;
+                        }
+                        break;
                     }
                     if (1 == r || 0 == r) {
-                        if(handshake_callback_) {
-                            handshake_callback_(this, r);
+                        if(handler_) {
+                            handler_->onSslHandshake(this, r);
                         }
                     }
+                    if (datagram_) {
+                        armDtlsTimer();
+                    }
+                    if (1 == r && !pending_writes_.empty()) {
+                        flushWrites();
+                    }
                     break;
                 }
 
                 case OP_READ: {
-                    r = SSL_read(ssl_, tbuf, sizeof(tbuf));
-                    if ( r == 0 ) goto handle_shutdown;
-
-                    if ( r > 0 ) {
-                        if ( read_callback_ ) {
-                            read_callback_(this, tbuf, r);
+                    // drain every complete record, the BIO pair may hold several
+                    while ( (r = SSL_read(ssl_, tbuf, sizeof(tbuf))) > 0 ) {
+                        if ( handler_ ) {
+                            handler_->onSslRead(this, tbuf, r);
                         }
                     }
-                    else {
-                        //write pending data, if nothing is pending, we assume
-                        //that SSL_read failed and shutdown
-                        bytes = sendPending();
-                        if ( bytes == 0 && read_callback_) {
-                            goto handle_shutdown;
-                        }
+                    if ( r == 0 ) goto handle_shutdown;
+
+                    int err = SSL_get_error(ssl_, r);
+                    //write pending data, if nothing is pending and SSL_read did not
+                    //just run out of input, we assume that SSL_read failed and shutdown
+                    bytes = sendPending();
+                    if ( err == SSL_ERROR_ZERO_RETURN ) goto handle_shutdown;
+                    if ( bytes == 0 && err != SSL_ERROR_WANT_READ && err != SSL_ERROR_WANT_WRITE ) {
+                        goto handle_shutdown;
                     }
                     break;
                 }
@@ -175,8 +547,8 @@ namespace jcu {
                     r = SSL_write(ssl_, buf, sz);
                     if ( 0 == r) goto handle_shutdown;
                     bytes = sendPending();
-                    if ( r > 0 && write_callback_) {
-                        write_callback_(this, r);
+                    if ( r > 0 && handler_ ) {
+                        handler_->onSslWrite(this, r);
                     }
                     break;
                 }
@@ -192,10 +564,17 @@ namespace jcu {
                      * */
 
                 case OP_SHUTDOWN: {
-                    r = SSL_shutdown(ssl_);
-                    bytes = sendPending();
-                    if ( close_callback_ ) {
-                        close_callback_(this, r);
+                    for(;;) {
+                        r = SSL_shutdown(ssl_);
+                        bytes = sendPending();
+                        if((r < 0) && (bytes > 0) && (SSL_get_error(ssl_, r) == SSL_ERROR_WANT_WRITE) &&
+                           (BIO_ctrl_get_write_guarantee(ssl_bio_) > 0)) {
+                            continue;
+                        }
+                        break;
+                    }
+                    if ( handler_ ) {
+                        handler_->onSslClose(this, r);
                     }
                     break;
                 }
@@ -212,8 +591,8 @@ namespace jcu {
             //it might be possible that peer send close_notify and close the network
             //hence, no check if sending is complete
             bytes = sendPending();
-            if ( (1 == r)  && close_callback_ ) {
-                close_callback_(this, r);
+            if ( (1 == r)  && handler_ ) {
+                handler_->onSslClose(this, r);
             }
             return r;
         }
@@ -223,6 +602,8 @@ namespace jcu {
             std::shared_ptr<Transport> transport = transport_.lock();
 
             // assert( conn != NULL);
+            if ( !app_bio_ )
+                return 0;
             int pending = BIO_pending(app_bio_);
             if ( !(pending > 0) )
                 return 0;
@@ -231,20 +612,92 @@ namespace jcu {
 
             int p = BIO_read(app_bio_, buf.get(), pending);
             if(p != pending) {
-                if(error_callback_) {
+                if(handler_) {
                     OpensslSslEngineError err((p < 0) ? p : 0, "BIO_read", "BIO_read failed");
                     //int code, const std::string &name, const std::string &what
-                    error_callback_(this, err);
+                    handler_->onSslError(this, err);
                 }
                 return -1;
             }
             // assert(p == pending);
 
+            if(datagram_) {
+                return sendDatagrams(std::move(buf), p);
+            }
+
             // assert( conn->writer != NULL && "You need to set network writer first");
             transport->write(std::move(buf), pending);
             
             return p;
         }
 
+        int OpensslSslEngine::OpensslSocketContext::sendDatagrams(std::unique_ptr<char[]> buf, int length) {
+            static const int DTLS_RECORD_HEADER_LENGTH = 13;
+
+            std::shared_ptr<Transport> transport = transport_.lock();
+            const unsigned char *data = (const unsigned char *)buf.get();
+            int offset = 0;
+
+            while(offset < length) {
+                int end = offset;
+                // pack whole records: type(1) version(2) epoch(2) sequence(6) length(2)
+                while(end < length) {
+                    int record_length = length - end;
+                    if(record_length > DTLS_RECORD_HEADER_LENGTH) {
+                        record_length = std::min(record_length,
+                            DTLS_RECORD_HEADER_LENGTH + ((data[end + 11] << 8) | data[end + 12]));
+                    }
+                    if((end > offset) && (end + record_length - offset > datagram_mtu_)) {
+                        break;
+                    }
+                    end += record_length;
+                }
+
+                if((offset == 0) && (end == length)) {
+                    transport->write(std::move(buf), length);
+                    break;
+                }
+                std::unique_ptr<char[]> datagram(new char[end - offset]);
+                memcpy(datagram.get(), data + offset, end - offset);
+                transport->write(std::move(datagram), end - offset);
+                offset = end;
+            }
+
+            return length;
+        }
+
+        void OpensslSslEngine::OpensslSocketContext::armDtlsTimer() {
+            struct timeval timeout = {0};
+            if(DTLSv1_get_timeout(ssl_, &timeout) <= 0) {
+                if(dtls_timer_) {
+                    dtls_timer_->stop();
+                }
+                return;
+            }
+
+            if(!dtls_timer_) {
+                std::shared_ptr<Transport> transport = transport_.lock();
+                std::shared_ptr<uvw::Loop> loop = transport ? transport->getLoop() : nullptr;
+                if(!loop) {
+                    return;
+                }
+                dtls_timer_ = loop->resource<uvw::TimerHandle>();
+                dtls_timer_->on<uvw::TimerEvent>([this](uvw::TimerEvent &evt, uvw::TimerHandle &handle) -> void {
+                    // retransmit the last flight
+                    std::shared_ptr<OpensslSocketContext> self = self_.lock();
+                    if(!attachBio()) {
+                        return;
+                    }
+                    if(DTLSv1_handle_timeout(ssl_) > 0) {
+                        sendPending();
+                    }
+                    armDtlsTimer();
+                });
+            }
+
+            uint64_t timeout_ms = (uint64_t)timeout.tv_sec * 1000 + timeout.tv_usec / 1000;
+            dtls_timer_->start(uvw::TimerHandle::Time(timeout_ms ? timeout_ms : 1), uvw::TimerHandle::Time(0));
+        }
+
     }
 }
@@ -0,0 +1,157 @@
+/**
+ * @file	rate_limiter.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/rate_limiter.h>
+
+#include <math.h>
+
+namespace jcu {
+    namespace transport {
+
+        TokenBucket::TokenBucket(uint64_t rate, uint64_t burst)
+            : rate_(0), burst_(0), tokens_(0), updated_at_(std::chrono::steady_clock::now()) {
+            setRate(rate, burst);
+        }
+
+        void TokenBucket::setRate(uint64_t rate, uint64_t burst) {
+            rate_ = rate;
+            burst_ = burst ? burst : rate;
+            tokens_ = (double)burst_;
+            updated_at_ = std::chrono::steady_clock::now();
+        }
+
+        uint64_t TokenBucket::getRate() const {
+            return rate_;
+        }
+
+        bool TokenBucket::isLimited() const {
+            return rate_ != 0;
+        }
+
+        void TokenBucket::refill(std::chrono::steady_clock::time_point now) {
+            if(now <= updated_at_) {
+                return;
+            }
+            double elapsed = std::chrono::duration<double>(now - updated_at_).count();
+            tokens_ += elapsed * (double)rate_;
+            if(tokens_ > (double)burst_) {
+                tokens_ = (double)burst_;
+            }
+            updated_at_ = now;
+        }
+
+        bool TokenBucket::available(std::chrono::steady_clock::time_point now) {
+            if(!rate_) {
+                return true;
+            }
+            refill(now);
+            return tokens_ > 0;
+        }
+
+        void TokenBucket::consume(size_t bytes, std::chrono::steady_clock::time_point now) {
+            if(!rate_) {
+                return;
+            }
+            refill(now);
+            tokens_ -= (double)bytes;
+        }
+
+        std::chrono::steady_clock::duration TokenBucket::waitTime(std::chrono::steady_clock::time_point now) {
+            if(!rate_) {
+                return std::chrono::steady_clock::duration::zero();
+            }
+            refill(now);
+            if(tokens_ > 0) {
+                return std::chrono::steady_clock::duration::zero();
+            }
+            // until the debt is repaid plus one byte
+            double seconds = (1.0 - tokens_) / (double)rate_;
+            return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+        }
+
+        RateMeter::RateMeter(uint64_t tau_ms)
+            : tau_((double)tau_ms / 1000.0), rate_(0), updated_at_(std::chrono::steady_clock::now()) {
+        }
+
+        void RateMeter::decay(std::chrono::steady_clock::time_point now) {
+            if(now <= updated_at_) {
+                return;
+            }
+            double elapsed = std::chrono::duration<double>(now - updated_at_).count();
+            rate_ *= exp(-elapsed / tau_);
+            updated_at_ = now;
+        }
+
+        void RateMeter::add(size_t bytes, std::chrono::steady_clock::time_point now) {
+            decay(now);
+            rate_ += (double)bytes / tau_;
+        }
+
+        double RateMeter::getRate(std::chrono::steady_clock::time_point now) {
+            decay(now);
+            return rate_;
+        }
+
+        std::shared_ptr<ShapingGroup> ShapingGroup::create(std::shared_ptr<ShapingGroup> parent) {
+            std::shared_ptr<ShapingGroup> instance(new ShapingGroup(parent));
+            return instance;
+        }
+
+        ShapingGroup::ShapingGroup(std::shared_ptr<ShapingGroup> parent)
+            : parent_(parent) {
+        }
+
+        const std::shared_ptr<ShapingGroup> &ShapingGroup::getParent() const {
+            return parent_;
+        }
+
+        void ShapingGroup::setWriteRate(uint64_t rate, uint64_t burst) {
+            buckets_[DIRECTION_WRITE].setRate(rate, burst);
+        }
+
+        void ShapingGroup::setReadRate(uint64_t rate, uint64_t burst) {
+            buckets_[DIRECTION_READ].setRate(rate, burst);
+        }
+
+        double ShapingGroup::getWriteRate() {
+            return meters_[DIRECTION_WRITE].getRate(std::chrono::steady_clock::now());
+        }
+
+        double ShapingGroup::getReadRate() {
+            return meters_[DIRECTION_READ].getRate(std::chrono::steady_clock::now());
+        }
+
+        bool ShapingGroup::available(Direction direction, std::chrono::steady_clock::time_point now) {
+            for(ShapingGroup *group = this; group; group = group->parent_.get()) {
+                if(!group->buckets_[direction].available(now)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void ShapingGroup::consume(Direction direction, size_t bytes, std::chrono::steady_clock::time_point now) {
+            for(ShapingGroup *group = this; group; group = group->parent_.get()) {
+                group->buckets_[direction].consume(bytes, now);
+                group->meters_[direction].add(bytes, now);
+            }
+        }
+
+        std::chrono::steady_clock::duration ShapingGroup::waitTime(Direction direction, std::chrono::steady_clock::time_point now) {
+            std::chrono::steady_clock::duration wait = std::chrono::steady_clock::duration::zero();
+            for(ShapingGroup *group = this; group; group = group->parent_.get()) {
+                std::chrono::steady_clock::duration group_wait = group->buckets_[direction].waitTime(now);
+                if(group_wait > wait) {
+                    wait = group_wait;
+                }
+            }
+            return wait;
+        }
+    }
+}
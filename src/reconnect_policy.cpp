@@ -0,0 +1,90 @@
+/**
+ * @file	reconnect_policy.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/reconnect_policy.h>
+#include <jcu/transport/shared_registry.h>
+
+namespace jcu {
+    namespace transport {
+
+        std::shared_ptr<CircuitBreaker> CircuitBreaker::create(int failure_threshold, uint64_t open_duration_ms) {
+            std::shared_ptr<CircuitBreaker> instance(new CircuitBreaker(failure_threshold, open_duration_ms));
+            return instance;
+        }
+
+        std::shared_ptr<CircuitBreaker> CircuitBreaker::forEndpoint(const std::string &endpoint, int failure_threshold, uint64_t open_duration_ms) {
+            static SharedRegistry<std::string, CircuitBreaker> registry;
+            return registry.get(endpoint, [failure_threshold, open_duration_ms]() -> std::shared_ptr<CircuitBreaker> {
+                return create(failure_threshold, open_duration_ms);
+            });
+        }
+
+        CircuitBreaker::CircuitBreaker(int failure_threshold, uint64_t open_duration_ms)
+            : failure_threshold_(failure_threshold), open_duration_(open_duration_ms),
+              state_(STATE_CLOSED), consecutive_failures_(0), probe_in_flight_(false) {
+        }
+
+        uint64_t CircuitBreaker::acquire() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            switch(state_) {
+                case STATE_CLOSED:
+                    return 0;
+
+                case STATE_OPEN: {
+                    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - opened_at_;
+                    if(elapsed < open_duration_) {
+                        uint64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(open_duration_ - elapsed).count();
+                        return remaining ? remaining : 1;
+                    }
+                    state_ = STATE_HALF_OPEN;
+                    probe_in_flight_ = true;
+                    return 0;
+                }
+
+                case STATE_HALF_OPEN:
+                    if(probe_in_flight_) {
+                        return open_duration_.count() ? open_duration_.count() : 1;
+                    }
+                    probe_in_flight_ = true;
+                    return 0;
+            }
+            return 0;
+        }
+
+        void CircuitBreaker::recordSuccess() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_ = STATE_CLOSED;
+            consecutive_failures_ = 0;
+            probe_in_flight_ = false;
+        }
+
+        void CircuitBreaker::recordFailure() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            consecutive_failures_++;
+            probe_in_flight_ = false;
+            if((state_ == STATE_HALF_OPEN) || ((state_ == STATE_CLOSED) && (consecutive_failures_ >= failure_threshold_))) {
+                state_ = STATE_OPEN;
+                opened_at_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        void CircuitBreaker::release() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(state_ == STATE_HALF_OPEN) {
+                probe_in_flight_ = false;
+            }
+        }
+
+        CircuitBreaker::State CircuitBreaker::getState() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return state_;
+        }
+
+    }
+}
@@ -0,0 +1,206 @@
+/**
+ * @file	replay_transport.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/replay_transport.h>
+
+#include <string.h>
+
+namespace jcu {
+    namespace transport {
+
+        std::shared_ptr<ReplayTransport> ReplayTransport::create(std::shared_ptr<uvw::Loop> loop, std::shared_ptr<CaptureReader> reader, uint32_t connection_id, Speed speed) {
+            std::shared_ptr<ReplayTransport> instance(new ReplayTransport(loop));
+            instance->self_ = instance;
+            instance->reader_ = reader;
+            instance->connection_id_ = connection_id;
+            instance->speed_ = speed;
+
+            const std::vector<CaptureReader::Record> &records = reader->getRecords();
+            for(std::vector<CaptureReader::Record>::const_iterator iter = records.begin(); iter != records.end(); ++iter) {
+                if(iter->connection_id != connection_id) {
+                    continue;
+                }
+                switch(iter->type) {
+                    case CAPTURE_CONNECT:
+                    case CAPTURE_READ:
+                    case CAPTURE_END:
+                    case CAPTURE_CLOSE:
+                        instance->events_.push_back(&(*iter));
+                        break;
+                    default:
+                        break;
+                }
+            }
+            return instance;
+        }
+
+        ReplayTransport::ReplayTransport(std::shared_ptr<uvw::Loop> loop)
+            : Transport(loop), connection_id_(0), speed_(REPLAY_RECORDED_SPEED), next_(0), base_timestamp_ns_(0),
+              connected_(false), closing_(false), read_paused_(false), bytes_written_(0), write_count_(0) {
+
+        }
+
+        ReplayTransport::~ReplayTransport() {
+            if(timer_) {
+                timer_->close();
+            }
+        }
+
+        void ReplayTransport::connect(Handler *handler) {
+            handler_ = handler;
+
+            reconnect();
+        }
+        void ReplayTransport::reconnect() {
+            if(!timer_) {
+                timer_ = loop_->resource<uvw::TimerHandle>();
+                timer_->on<uvw::TimerEvent>([this](uvw::TimerEvent &evt, uvw::TimerHandle &handle) -> void {
+                    replayNext();
+                });
+            }
+            timer_->stop();
+
+            next_ = 0;
+            connected_ = false;
+            closing_ = false;
+            base_timestamp_ns_ = events_.empty() ? 0 : events_.front()->timestamp_ns;
+            started_at_ = std::chrono::steady_clock::now();
+            scheduleNext();
+        }
+        void ReplayTransport::disconnect() {
+            if(!connected_ || !timer_) {
+                return;
+            }
+            // reported from the loop like a socket close, never from inside the caller
+            closing_ = true;
+            timer_->stop();
+            timer_->start(uvw::TimerHandle::Time(0), uvw::TimerHandle::Time(0));
+        }
+        void ReplayTransport::cleanup() {
+            if(timer_) {
+                timer_->stop();
+            }
+            handler_ = nullptr;
+        }
+        void ReplayTransport::setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) {
+        }
+        void ReplayTransport::write(std::unique_ptr<char[]> data, size_t length) {
+            bytes_written_ += length;
+            write_count_++;
+        }
+
+        void ReplayTransport::pauseRead() {
+            if(read_paused_) {
+                return;
+            }
+            read_paused_ = true;
+            if(timer_ && !closing_) {
+                timer_->stop();
+            }
+        }
+        void ReplayTransport::resumeRead() {
+            if(!read_paused_) {
+                return;
+            }
+            read_paused_ = false;
+            if(timer_ && !closing_ && (next_ < events_.size())) {
+                // shift the timeline by the time spent paused
+                uint64_t due_ns = events_[next_]->timestamp_ns - base_timestamp_ns_;
+                started_at_ = std::chrono::steady_clock::now() - std::chrono::nanoseconds(due_ns);
+                scheduleNext();
+            }
+        }
+
+        bool ReplayTransport::isFinished() const {
+            return next_ >= events_.size();
+        }
+
+        uint64_t ReplayTransport::getBytesWritten() const {
+            return bytes_written_;
+        }
+
+        uint64_t ReplayTransport::getWriteCount() const {
+            return write_count_;
+        }
+
+        void ReplayTransport::scheduleNext() {
+            if(read_paused_ || (next_ >= events_.size())) {
+                return;
+            }
+
+            uint64_t delay_ms = 0;
+            if(speed_ == REPLAY_RECORDED_SPEED) {
+                uint64_t due_ns = events_[next_]->timestamp_ns - base_timestamp_ns_;
+                uint64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - started_at_).count();
+                if(due_ns > elapsed_ns) {
+                    delay_ms = (due_ns - elapsed_ns) / 1000000;
+                }
+            }
+            // one event per loop iteration, so the stack reacts to each chunk as it would live
+            timer_->start(uvw::TimerHandle::Time(delay_ms), uvw::TimerHandle::Time(0));
+        }
+
+        void ReplayTransport::replayNext() {
+            std::shared_ptr<ReplayTransport> self = self_.lock();
+
+            if(closing_) {
+                closing_ = false;
+                connected_ = false;
+                next_ = events_.size();
+                if(handler_) {
+                    handler_->onTransportClose(*this);
+                }
+                return;
+            }
+            if(next_ >= events_.size()) {
+                return;
+            }
+
+            const CaptureReader::Record *record = events_[next_++];
+            switch(record->type) {
+                case CAPTURE_CONNECT:
+                    connected_ = true;
+                    if(handler_) {
+                        handler_->onTransportConnect(*this);
+                    }
+                    break;
+                case CAPTURE_READ:
+                    if(handler_ && connected_) {
+                        std::unique_ptr<char[]> data(new char[record->length]);
+                        memcpy(data.get(), record->payload, record->payload_length);
+                        if(record->payload_length < record->length) {
+                            memset(data.get() + record->payload_length, 0, record->length - record->payload_length);
+                        }
+                        handler_->onTransportData(*this, std::move(data), record->length);
+                    }
+                    break;
+                case CAPTURE_END:
+                    if(handler_ && connected_) {
+                        handler_->onTransportEnd(*this);
+                    }
+                    break;
+                case CAPTURE_CLOSE:
+                    if(connected_) {
+                        connected_ = false;
+                        if(handler_) {
+                            handler_->onTransportClose(*this);
+                        }
+                    }
+                    break;
+                default:
+                    break;
+            }
+
+            if(!closing_) {
+                scheduleNext();
+            }
+        }
+    }
+}
@@ -0,0 +1,398 @@
+/**
+ * @file	shaped_transport.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/shaped_transport.h>
+#include <jcu/transport/shared_registry.h>
+
+#include <algorithm>
+
+namespace jcu {
+    namespace transport {
+
+        std::shared_ptr<ShapingScheduler> ShapingScheduler::forLoop(std::shared_ptr<uvw::Loop> loop) {
+            static SharedRegistry<uvw::Loop*, ShapingScheduler> registry;
+            return registry.get(loop.get(), [&loop]() -> std::shared_ptr<ShapingScheduler> {
+                std::shared_ptr<ShapingScheduler> instance(new ShapingScheduler(loop));
+                instance->self_ = instance;
+                return instance;
+            });
+        }
+
+        ShapingScheduler::ShapingScheduler(std::shared_ptr<uvw::Loop> loop)
+            : loop_(loop), deferred_(loop, [this]() -> void { run(); }), running_(false), quantum_(16 * 1024) {
+        }
+
+        ShapingScheduler::~ShapingScheduler() {
+            if(timer_) {
+                timer_->close();
+            }
+        }
+
+        void ShapingScheduler::setQuantum(size_t quantum) {
+            quantum_ = quantum ? quantum : 1;
+        }
+
+        double ShapingScheduler::getWriteRate() {
+            return write_meter_.getRate(std::chrono::steady_clock::now());
+        }
+
+        double ShapingScheduler::getReadRate() {
+            return read_meter_.getRate(std::chrono::steady_clock::now());
+        }
+
+        size_t ShapingScheduler::getBackloggedCount() const {
+            return (size_t)std::count_if(active_.begin(), active_.end(), [](ShapedTransport *transport) -> bool {
+                return transport != nullptr;
+            });
+        }
+
+        void ShapingScheduler::activate(ShapedTransport *transport) {
+            if(!transport->write_active_) {
+                transport->write_active_ = true;
+                active_.push_back(transport);
+            }
+            schedule();
+        }
+
+        void ShapingScheduler::throttle(ShapedTransport *transport) {
+            if(!transport->read_throttled_) {
+                transport->read_throttled_ = true;
+                throttled_.push_back(transport);
+            }
+            schedule();
+        }
+
+        void ShapingScheduler::remove(ShapedTransport *transport) {
+            transport->write_active_ = false;
+            transport->read_throttled_ = false;
+            if(running_) {
+                // run() holds iterators, leave the entries for it to erase
+                std::replace(active_.begin(), active_.end(), transport, (ShapedTransport*)nullptr);
+                std::replace(throttled_.begin(), throttled_.end(), transport, (ShapedTransport*)nullptr);
+            } else {
+                active_.remove(transport);
+                throttled_.remove(transport);
+            }
+        }
+
+        void ShapingScheduler::schedule() {
+            if(running_) {
+                return;
+            }
+            if(!timer_) {
+                timer_ = loop_->resource<uvw::TimerHandle>();
+                timer_->on<uvw::TimerEvent>([this](uvw::TimerEvent &evt, uvw::TimerHandle &handle) -> void {
+                    run();
+                });
+            }
+            deferred_.schedule();
+        }
+
+        void ShapingScheduler::run() {
+            // the last transport may go away during the pass
+            std::shared_ptr<ShapingScheduler> self = self_.lock();
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+            // also covers the runs of the timer
+            deferred_.cancel();
+            running_ = true;
+
+            // active_ is the round robin order: a transport goes to the back once its turn
+            // is over. One that cannot write for lack of group tokens keeps its place, so
+            // the transports of a group take their turns in order as the group refills.
+            bool progress = true;
+            while(progress && !active_.empty()) {
+                progress = false;
+                std::list<ShapedTransport*>::iterator iter = active_.begin();
+                for(size_t remaining = active_.size(); (remaining > 0) && (iter != active_.end()); remaining--) {
+                    std::list<ShapedTransport*>::iterator next = std::next(iter);
+                    std::shared_ptr<ShapedTransport> transport = *iter ? (*iter)->self_.lock() : nullptr;
+                    if(!transport) {
+                        active_.erase(iter);
+                        iter = next;
+                        continue;
+                    }
+                    if(!transport->canWrite(now)) {
+                        iter = next;
+                        continue;
+                    }
+
+                    // one quantum per round, kept while the turn waits for tokens
+                    if(!transport->credited_) {
+                        transport->deficit_ += quantum_ * transport->weight_;
+                        transport->credited_ = true;
+                    }
+                    while(*iter && !transport->write_queue_.empty() &&
+                          (transport->write_queue_.front().second <= transport->deficit_) &&
+                          transport->canWrite(now)) {
+                        std::pair<std::unique_ptr<char[]>, size_t> item = std::move(transport->write_queue_.front());
+                        transport->write_queue_.pop_front();
+                        transport->queued_bytes_ -= item.second;
+                        transport->deficit_ -= item.second;
+                        transport->send(std::move(item.first), item.second, now);
+                        progress = true;
+                    }
+
+                    if(!*iter || transport->write_queue_.empty()) {
+                        transport->deficit_ = 0;
+                        transport->credited_ = false;
+                        transport->write_active_ = false;
+                        active_.erase(iter);
+                        iter = next;
+                        continue;
+                    }
+                    if(transport->write_queue_.front().second > transport->deficit_) {
+                        // turn over, it is credited again in the next round
+                        transport->credited_ = false;
+                        active_.splice(active_.end(), active_, iter);
+                        progress = true;
+                    } else if(!transport->write_bucket_.available(now)) {
+                        // its own limit ends the turn, the group tokens go to the others
+                        transport->credited_ = false;
+                        active_.splice(active_.end(), active_, iter);
+                    }
+                    iter = next;
+                }
+            }
+
+            std::chrono::steady_clock::duration wait = std::chrono::steady_clock::duration::max();
+            for(std::list<ShapedTransport*>::iterator iter = active_.begin(); iter != active_.end(); ) {
+                if(!*iter) {
+                    iter = active_.erase(iter);
+                    continue;
+                }
+                wait = std::min(wait, (*iter)->writeWaitTime(now));
+                ++iter;
+            }
+            for(std::list<ShapedTransport*>::iterator iter = throttled_.begin(); iter != throttled_.end(); ) {
+                if(!*iter) {
+                    iter = throttled_.erase(iter);
+                    continue;
+                }
+                if((*iter)->canRead(now)) {
+                    std::shared_ptr<ShapedTransport> transport = (*iter)->self_.lock();
+                    iter = throttled_.erase(iter);
+                    if(transport) {
+                        transport->unthrottle();
+                    }
+                    continue;
+                }
+                wait = std::min(wait, (*iter)->readWaitTime(now));
+                ++iter;
+            }
+
+            running_ = false;
+
+            if(wait == std::chrono::steady_clock::duration::max()) {
+                if(timer_) {
+                    timer_->stop();
+                }
+                return;
+            }
+            uint64_t wait_ms = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(wait).count() + 1;
+            timer_->start(uvw::TimerHandle::Time(wait_ms), uvw::TimerHandle::Time(0));
+        }
+
+        std::shared_ptr<ShapedTransport> ShapedTransport::create(std::shared_ptr<uvw::Loop> loop, std::shared_ptr<Transport> transport, std::shared_ptr<ShapingGroup> group) {
+            std::shared_ptr<ShapedTransport> instance(new ShapedTransport(loop));
+            instance->self_ = instance;
+            instance->transport_ = transport;
+            instance->scheduler_ = ShapingScheduler::forLoop(loop);
+            instance->group_ = group;
+            return instance;
+        }
+
+        ShapedTransport::ShapedTransport(std::shared_ptr<uvw::Loop> loop)
+            : Transport(loop), weight_(1), queued_bytes_(0), deficit_(0), credited_(false), write_active_(false),
+              read_throttled_(false), read_paused_(false) {
+
+        }
+
+        ShapedTransport::~ShapedTransport() {
+            if(scheduler_) {
+                scheduler_->remove(this);
+            }
+        }
+
+        void ShapedTransport::setWriteRate(uint64_t rate, uint64_t burst) {
+            write_bucket_.setRate(rate, burst);
+        }
+
+        void ShapedTransport::setReadRate(uint64_t rate, uint64_t burst) {
+            read_bucket_.setRate(rate, burst);
+        }
+
+        void ShapedTransport::setWeight(uint32_t weight) {
+            weight_ = weight ? weight : 1;
+        }
+
+        double ShapedTransport::getWriteRate() {
+            return write_meter_.getRate(std::chrono::steady_clock::now());
+        }
+
+        double ShapedTransport::getReadRate() {
+            return read_meter_.getRate(std::chrono::steady_clock::now());
+        }
+
+        size_t ShapedTransport::getQueuedBytes() const {
+            return queued_bytes_;
+        }
+
+        bool ShapedTransport::canWrite(std::chrono::steady_clock::time_point now) {
+            if(!write_bucket_.available(now)) {
+                return false;
+            }
+            return !group_ || group_->available(ShapingGroup::DIRECTION_WRITE, now);
+        }
+
+        bool ShapedTransport::canRead(std::chrono::steady_clock::time_point now) {
+            if(!read_bucket_.available(now)) {
+                return false;
+            }
+            return !group_ || group_->available(ShapingGroup::DIRECTION_READ, now);
+        }
+
+        std::chrono::steady_clock::duration ShapedTransport::writeWaitTime(std::chrono::steady_clock::time_point now) {
+            std::chrono::steady_clock::duration wait = write_bucket_.waitTime(now);
+            if(group_) {
+                wait = std::max(wait, group_->waitTime(ShapingGroup::DIRECTION_WRITE, now));
+            }
+            return wait;
+        }
+
+        std::chrono::steady_clock::duration ShapedTransport::readWaitTime(std::chrono::steady_clock::time_point now) {
+            std::chrono::steady_clock::duration wait = read_bucket_.waitTime(now);
+            if(group_) {
+                wait = std::max(wait, group_->waitTime(ShapingGroup::DIRECTION_READ, now));
+            }
+            return wait;
+        }
+
+        void ShapedTransport::send(std::unique_ptr<char[]> data, size_t length, std::chrono::steady_clock::time_point now) {
+            write_bucket_.consume(length, now);
+            write_meter_.add(length, now);
+            scheduler_->write_meter_.add(length, now);
+            if(group_) {
+                group_->consume(ShapingGroup::DIRECTION_WRITE, length, now);
+            }
+            transport_->write(std::move(data), length);
+        }
+
+        void ShapedTransport::unthrottle() {
+            read_throttled_ = false;
+            if(!read_paused_) {
+                transport_->resumeRead();
+            }
+        }
+
+        void ShapedTransport::connect(Transport::Handler *handler) {
+            handler_ = handler;
+            transport_->connect(static_cast<Transport::Handler*>(this));
+        }
+
+        void ShapedTransport::onTransportConnect(Transport &transport) {
+            if(handler_) {
+                handler_->onTransportConnect(*this);
+            }
+        }
+        void ShapedTransport::onTransportClose(Transport &transport) {
+            if(handler_) {
+                handler_->onTransportClose(*this);
+            }
+        }
+        void ShapedTransport::onTransportError(Transport &transport, Error &err) {
+            if(handler_) {
+                handler_->onTransportError(*this, err);
+            }
+        }
+        bool ShapedTransport::onTransportEnd(Transport &transport) {
+            if(handler_) {
+                return handler_->onTransportEnd(*this);
+            }
+            return false;
+        }
+        void ShapedTransport::onTransportData(Transport &transport, std::unique_ptr<char[]> data, size_t length) {
+            std::shared_ptr<ShapedTransport> self = self_.lock();
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+            read_bucket_.consume(length, now);
+            read_meter_.add(length, now);
+            scheduler_->read_meter_.add(length, now);
+            if(group_) {
+                group_->consume(ShapingGroup::DIRECTION_READ, length, now);
+            }
+
+            if(handler_) {
+                handler_->onTransportData(*this, std::move(data), length);
+            }
+
+            if(!read_throttled_ && !canRead(now)) {
+                transport_->pauseRead();
+                scheduler_->throttle(this);
+            }
+        }
+
+        void ShapedTransport::reconnect() {
+            transport_->reconnect();
+        }
+        void ShapedTransport::disconnect() {
+            transport_->disconnect();
+        }
+        void ShapedTransport::closeConnection() {
+            transport_->closeConnection();
+        }
+        void ShapedTransport::cleanup() {
+            transport_->cleanup();
+            handler_ = nullptr;
+            scheduler_->remove(this);
+            write_queue_.clear();
+            queued_bytes_ = 0;
+            deficit_ = 0;
+            credited_ = false;
+            if(read_throttled_ && !read_paused_) {
+                transport_->resumeRead();
+            }
+            read_throttled_ = false;
+        }
+        void ShapedTransport::setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) {
+            transport_->setReconnectPolicy(policy, [this, on_state](Transport& transport, ReconnectState state, int attempt, uint64_t delay_ms) -> void {
+                if(on_state) {
+                    on_state(*this, state, attempt, delay_ms);
+                }
+            });
+        }
+        void ShapedTransport::write(std::unique_ptr<char[]> data, size_t length) {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+            // nothing waits on the loop: no ordering or fairness to keep
+            if(write_queue_.empty() && scheduler_->active_.empty() && canWrite(now)) {
+                send(std::move(data), length, now);
+                return;
+            }
+
+            write_queue_.push_back(std::make_pair(std::move(data), length));
+            queued_bytes_ += length;
+            scheduler_->activate(this);
+        }
+
+        void ShapedTransport::pauseRead() {
+            read_paused_ = true;
+            transport_->pauseRead();
+        }
+        void ShapedTransport::resumeRead() {
+            read_paused_ = false;
+            if(!read_throttled_) {
+                transport_->resumeRead();
+            }
+        }
+        uint32_t ShapedTransport::getCaptureId() const {
+            return transport_->getCaptureId();
+        }
+    }
+}
@@ -9,6 +9,8 @@
 
 #include <jcu/transport/tcp_transport.h>
 
+#include <algorithm>
+
 namespace jcu {
     namespace transport {
 
@@ -25,6 +27,13 @@ namespace jcu {
                 if(what) what_ = what;
                 code_ = evt.code();
             }
+            TcpTransportError(int code) {
+                const char *name = uv_err_name(code);
+                const char *what = uv_strerror(code);
+                if(name) name_ = name;
+                if(what) what_ = what;
+                code_ = code;
+            }
 
             const char *what() const override {
                 return what_.c_str();
@@ -46,12 +55,23 @@ namespace jcu {
             return instance;
         }
 
-        TcpTransport::TcpTransport(std::shared_ptr<uvw::Loop> loop) : Transport(loop) {
+        TcpTransport::TcpTransport(std::shared_ptr<uvw::Loop> loop)
+            : Transport(loop), handle_state_(HANDLE_CLOSED), reopen_on_close_(false), has_data_connection_(false),
+              remote_port_(0), connected_(false), user_disconnect_(false), read_paused_(false), queued_bytes_(0),
+              breaker_acquired_(false), reconnect_pending_(false), reconnect_attempts_(0), reconnect_delay_ms_(0),
+              random_(std::random_device()()) {
 
         }
 
         TcpTransport::~TcpTransport() {
-
+            releaseBreaker();
+            if(sock_handle_) {
+                sock_handle_->clear();
+                closeHandle();
+            }
+            if(reconnect_timer_) {
+                reconnect_timer_->close();
+            }
         }
 
         void TcpTransport::setRemote(const std::string& remote_ip, int remote_port) {
@@ -59,82 +79,294 @@ namespace jcu {
             remote_port_ = remote_port;
         }
 
-        void TcpTransport::connect(
-            const Transport::OnConnectCallback_t &on_connect,
-            const Transport::OnCloseCallback_t &on_close,
-            const OnErrorCallback_t& on_error
-            ) {
-            on_connect_ = on_connect;
-            on_close_ = on_close;
-            on_error_ = on_error;
+        void TcpTransport::connect(Handler *handler) {
+            handler_ = handler;
 
+            reconnect_attempts_ = 0;
+            reconnect_delay_ms_ = 0;
             reconnect();
         }
         void TcpTransport::reconnect() {
-            std::shared_ptr<TcpTransport> self = self_.lock();
-            std::shared_ptr<uvw::TCPHandle> sock_handle = loop_->resource<uvw::TCPHandle>();
-            sock_handle->data(self);
-            sock_handle->once<uvw::ShutdownEvent>([this](uvw::ShutdownEvent &evt, uvw::TCPHandle &handle) -> void {
-            });
-            sock_handle->on<uvw::EndEvent>([this](uvw::EndEvent &evt, uvw::TCPHandle &handle) -> void {
+            user_disconnect_ = false;
+            if(reconnect_policy_.enabled) {
+                // the supervisor already has an attempt running or scheduled
+                if(reconnect_pending_) {
+                    return;
+                }
+                reconnect_pending_ = true;
+                attemptConnect();
+                return;
+            }
+            openHandle();
+        }
+        std::shared_ptr<uvw::TCPHandle> TcpTransport::prepareHandle() {
+            if(!sock_handle_) {
+                sock_handle_ = loop_->resource<uvw::TCPHandle>();
+                handle_state_ = HANDLE_READY;
+                setupHandle();
+            } else if(handle_state_ == HANDLE_CLOSED) {
+                sock_handle_->init();
+                handle_state_ = HANDLE_READY;
+            }
+            return sock_handle_;
+        }
+        void TcpTransport::setupHandle() {
+            sock_handle_->on<uvw::EndEvent>([this](uvw::EndEvent &evt, uvw::TCPHandle &handle) -> void {
                 bool cancel = false;
-                if(on_end_) {
-                    cancel = on_end_(*this);
+                if(handler_) {
+                    cancel = handler_->onTransportEnd(*this);
                 }
                 if(!cancel) {
-                    handle.close();
+                    closeHandle();
                 }
             });
-            sock_handle->once<uvw::ConnectEvent>([this](uvw::ConnectEvent &evt, uvw::TCPHandle &handle) -> void {
-              handle.read();
-                if(on_connect_) {
-                    on_connect_(*this);
-                }
+            sock_handle_->on<uvw::ConnectEvent>([this](uvw::ConnectEvent &evt, uvw::TCPHandle &handle) -> void {
+              if(!read_paused_) {
+                  handle.read();
+              }
+              handleConnected();
             });
-            sock_handle->once<uvw::CloseEvent>([this](uvw::CloseEvent &evt, uvw::TCPHandle &handle) -> void {
-                if(on_close_) {
-                    on_close_(*this);
+            sock_handle_->on<uvw::CloseEvent>([this](uvw::CloseEvent &evt, uvw::TCPHandle &handle) -> void {
+                // the handle no longer keeps this transport alive once closed
+                std::shared_ptr<TcpTransport> self = self_.lock();
+                handle.data(nullptr);
+                handle_state_ = HANDLE_CLOSED;
+
+                bool was_connected = connected_;
+                connected_ = false;
+                bool reopen = reopen_on_close_;
+                reopen_on_close_ = false;
+                if(!reopen) {
+                    // arm the backoff first, so a reconnect() from the close handler waits for it
+                    handleClosed(was_connected);
+                }
+                if(handler_) {
+                    handler_->onTransportClose(*this);
+                }
+                if(reopen && !user_disconnect_ && (handle_state_ == HANDLE_CLOSED)) {
+                    openHandle();
                 }
             });
-            sock_handle->on<uvw::ErrorEvent>([this](uvw::ErrorEvent &evt, uvw::TCPHandle &handle) -> void {
+            sock_handle_->on<uvw::ErrorEvent>([this](uvw::ErrorEvent &evt, uvw::TCPHandle &handle) -> void {
                 TcpTransportError err(evt);
-                if(on_error_) {
-                    on_error_(*this, err);
+                if(handler_) {
+                    handler_->onTransportError(*this, err);
                 }
-                handle.close();
-            });
-            sock_handle->on<uvw::DataEvent>([this](uvw::DataEvent &evt, uvw::TCPHandle &handle) -> void {
-              if(on_data_) {
-                  on_data_(*this, std::move(evt.data), evt.length);
-              }
-            });
-            sock_handle->on<uvw::WriteEvent>([this](uvw::WriteEvent &evt, uvw::TCPHandle &handle) -> void {
-              // ...
+                closeHandle();
             });
+            if(!has_data_connection_) {
+                data_connection_ = sock_handle_->on<uvw::DataEvent>([this](uvw::DataEvent &evt, uvw::TCPHandle &handle) -> void {
+                  if(handler_) {
+                      handler_->onTransportData(*this, std::move(evt.data), evt.length);
+                  }
+                });
+                has_data_connection_ = true;
+            }
+        }
+        void TcpTransport::openHandle() {
+            if((handle_state_ == HANDLE_OPEN) || (handle_state_ == HANDLE_CLOSING)) {
+                // connect again once the current socket is closed
+                reopen_on_close_ = true;
+                closeHandle();
+                return;
+            }
+            std::shared_ptr<uvw::TCPHandle> sock_handle = prepareHandle();
+            sock_handle->data(self_.lock());
+            handle_state_ = HANDLE_OPEN;
             sock_handle->connect(remote_ip_, remote_port_);
-            sock_handle_ = sock_handle;
+        }
+        void TcpTransport::closeHandle() {
+            if(handle_state_ == HANDLE_OPEN || handle_state_ == HANDLE_READY) {
+                handle_state_ = HANDLE_CLOSING;
+                sock_handle_->close();
+            }
+        }
+        void TcpTransport::attemptConnect() {
+            if(!circuit_breaker_ && (reconnect_policy_.failure_threshold > 0)) {
+                circuit_breaker_ = CircuitBreaker::forEndpoint(
+                    remote_ip_ + ":" + std::to_string(remote_port_),
+                    reconnect_policy_.failure_threshold,
+                    reconnect_policy_.open_duration_ms);
+            }
+
+            // an attempt superseded by this one (its socket is reopened) never reports a result
+            releaseBreaker();
+            uint64_t wait_ms = circuit_breaker_ ? circuit_breaker_->acquire() : 0;
+            if(wait_ms > 0) {
+                notifyReconnectState(RECONNECT_CIRCUIT_OPEN, wait_ms);
+                reconnect_timer_->start(uvw::TimerHandle::Time(wait_ms), uvw::TimerHandle::Time(0));
+                return;
+            }
+
+            breaker_acquired_ = (circuit_breaker_ != nullptr);
+            notifyReconnectState(RECONNECT_CONNECTING, 0);
+            openHandle();
+        }
+        void TcpTransport::handleConnected() {
+            connected_ = true;
+            if(reconnect_policy_.enabled) {
+                if(circuit_breaker_) {
+                    circuit_breaker_->recordSuccess();
+                }
+                breaker_acquired_ = false;
+                reconnect_pending_ = false;
+                reconnect_attempts_ = 0;
+                reconnect_delay_ms_ = 0;
+                notifyReconnectState(RECONNECT_CONNECTED, 0);
+            }
+
+            while(!write_queue_.empty()) {
+                sock_handle_->write(std::move(write_queue_.front().first), write_queue_.front().second);
+                write_queue_.pop_front();
+            }
+            queued_bytes_ = 0;
+
+            if(handler_) {
+                handler_->onTransportConnect(*this);
+            }
+        }
+        void TcpTransport::handleClosed(bool was_connected) {
+            if(!reconnect_policy_.enabled || user_disconnect_) {
+                reconnect_pending_ = false;
+                return;
+            }
+
+            if(was_connected) {
+                // an established connection dropped, start over from the base delay
+                reconnect_attempts_ = 0;
+                reconnect_delay_ms_ = 0;
+            } else if(circuit_breaker_) {
+                circuit_breaker_->recordFailure();
+            }
+            breaker_acquired_ = false;
+            reconnect_pending_ = true;
+
+            reconnect_attempts_++;
+            if((reconnect_policy_.max_attempts > 0) && (reconnect_attempts_ > reconnect_policy_.max_attempts)) {
+                reconnect_pending_ = false;
+                clearWriteQueue();
+                notifyReconnectState(RECONNECT_GAVE_UP, 0);
+                return;
+            }
+
+            uint64_t base = reconnect_policy_.base_delay_ms;
+            uint64_t upper = std::max(base, reconnect_delay_ms_ * 3);
+            uint64_t delay = std::uniform_int_distribution<uint64_t>(base, upper)(random_);
+            reconnect_delay_ms_ = std::min(reconnect_policy_.max_delay_ms, delay);
+
+            notifyReconnectState(RECONNECT_BACKOFF, reconnect_delay_ms_);
+            reconnect_timer_->start(uvw::TimerHandle::Time(reconnect_delay_ms_), uvw::TimerHandle::Time(0));
+        }
+        void TcpTransport::releaseBreaker() {
+            if(breaker_acquired_) {
+                breaker_acquired_ = false;
+                circuit_breaker_->release();
+            }
+        }
+        void TcpTransport::clearWriteQueue() {
+            write_queue_.clear();
+            queued_bytes_ = 0;
+        }
+        void TcpTransport::rejectWrite(int code) {
+            TcpTransportError err(code);
+            if(handler_) {
+                handler_->onTransportError(*this, err);
+            }
+        }
+        void TcpTransport::notifyReconnectState(ReconnectState state, uint64_t delay_ms) {
+            if(on_reconnect_state_) {
+                on_reconnect_state_(*this, state, reconnect_attempts_, delay_ms);
+            }
+        }
+        void TcpTransport::setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) {
+            reconnect_policy_ = policy;
+            on_reconnect_state_ = on_state;
+            circuit_breaker_ = policy.circuit_breaker;
+            if(policy.enabled && !reconnect_timer_) {
+                reconnect_timer_ = loop_->resource<uvw::TimerHandle>();
+                reconnect_timer_->on<uvw::TimerEvent>([this](uvw::TimerEvent &evt, uvw::TimerHandle &handle) -> void {
+                    std::shared_ptr<TcpTransport> self = self_.lock();
+                    if(reconnect_pending_ && !user_disconnect_) {
+                        attemptConnect();
+                    }
+                });
+            }
         }
         void TcpTransport::disconnect() {
-            std::shared_ptr<uvw::TCPHandle> sock_handle = sock_handle_.lock();
-            if(sock_handle) {
-                sock_handle->shutdown();
-                sock_handle->close();
+            user_disconnect_ = true;
+            reconnect_pending_ = false;
+            releaseBreaker();
+            if(reconnect_timer_) {
+                reconnect_timer_->stop();
             }
+            reopen_on_close_ = false;
+            if(handle_state_ == HANDLE_OPEN) {
+                sock_handle_->shutdown();
+            }
+            closeHandle();
+        }
+        void TcpTransport::closeConnection() {
+            if(handle_state_ == HANDLE_OPEN) {
+                sock_handle_->shutdown();
+            }
+            closeHandle();
         }
         void TcpTransport::cleanup() {
             disconnect();
-            on_connect_ = nullptr;
-            on_close_ = nullptr;
+            handler_ = nullptr;
+            on_reconnect_state_ = nullptr;
+            clearWriteQueue();
         }
         void TcpTransport::onData(const OnDataCallback_t &on_data) {
-            on_data_ = on_data;
-        }
-        void TcpTransport::onEnd(const OnEndCallback_t &on_end) {
-            on_end_ = on_end;
+            if(data_handler_) {
+                // switch back from a handler bound with setDataHandler()
+                std::shared_ptr<uvw::TCPHandle> sock_handle = prepareHandle();
+                sock_handle->erase(data_connection_);
+                data_handler_ = nullptr;
+                data_connection_ = sock_handle->on<uvw::DataEvent>([this](uvw::DataEvent &evt, uvw::TCPHandle &handle) -> void {
+                    if(handler_) {
+                        handler_->onTransportData(*this, std::move(evt.data), evt.length);
+                    }
+                });
+            }
+            Transport::onData(on_data);
         }
         void TcpTransport::write(std::unique_ptr<char[]> data, size_t length) {
-            std::shared_ptr<uvw::TCPHandle> sock_handle = sock_handle_.lock();
-            sock_handle->write(std::move(data), length);
+            if(!connected_) {
+                // held only for an attempt that is connecting or will be retried by the policy
+                bool connecting = (handle_state_ == HANDLE_OPEN) || reopen_on_close_ || reconnect_pending_;
+                if(user_disconnect_ || !connecting) {
+                    rejectWrite(UV_ENOTCONN);
+                    return;
+                }
+                size_t max_queued_bytes = reconnect_policy_.max_queued_bytes;
+                if((max_queued_bytes > 0) && (queued_bytes_ + length > max_queued_bytes)) {
+                    rejectWrite(UV_ENOBUFS);
+                    return;
+                }
+                queued_bytes_ += length;
+                write_queue_.push_back(std::make_pair(std::move(data), length));
+                return;
+            }
+            sock_handle_->write(std::move(data), length);
+        }
+        void TcpTransport::pauseRead() {
+            if(read_paused_) {
+                return;
+            }
+            read_paused_ = true;
+            if(connected_) {
+                sock_handle_->stop();
+            }
+        }
+        void TcpTransport::resumeRead() {
+            if(!read_paused_) {
+                return;
+            }
+            read_paused_ = false;
+            if(connected_) {
+                sock_handle_->read();
+            }
         }
     }
 }
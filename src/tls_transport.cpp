@@ -9,6 +9,8 @@
 
 #include <jcu/transport/tls_transport.h>
 
+#include <string.h>
+
 namespace jcu {
     namespace transport {
 
@@ -20,7 +22,7 @@ namespace jcu {
             return instance;
         }
 
-        TlsTransport::TlsTransport(std::shared_ptr<uvw::Loop> loop) : Transport(loop) {
+        TlsTransport::TlsTransport(std::shared_ptr<uvw::Loop> loop) : Transport(loop), user_disconnect_(false), handshake_done_(false) {
 
         }
 
@@ -28,85 +30,133 @@ namespace jcu {
 
         }
 
-        void TlsTransport::connect(const Transport::OnConnectCallback_t &on_connect,
-                                   const Transport::OnCloseCallback_t &on_close,
-                                   const Transport::OnErrorCallback_t &on_error) {
-            on_connect_ = on_connect;
-            on_close_ = on_close;
-            on_error_ = on_error;
+        void TlsTransport::connect(Transport::Handler *handler) {
+            handler_ = handler;
+            user_disconnect_ = false;
+            transport_->connect(static_cast<Transport::Handler*>(this));
+        }
 
-            transport_->onEnd([this](Transport& transport) -> bool {
-                if(on_end_) {
-                    return on_end_(*this);
-                }
-                return false;
-            });
-            transport_->onData([this](Transport& transport, std::unique_ptr<char[]> data, size_t length) -> void {
-                if(ssl_socket_) {
-                    ssl_socket_->feedRead(std::move(data), length);
-                }
-            });
-            transport_->connect([this](Transport& transport) -> void {
-              std::shared_ptr<TlsTransport> self = self_.lock();
-              ssl_socket_ = engine_->createContext(
-                  transport_,
-                  [this](SslEngine::SocketContext *socket_context, int status) -> void {
-                    // Handshake
-                    if(on_connect_) {
-                        on_connect_(*this);
-                    }
-                  },
-                  [this](SslEngine::SocketContext *socket_context, int status) -> void {
-                    // Write
+        void TlsTransport::onTransportConnect(Transport &transport) {
+            std::shared_ptr<TlsTransport> self = self_.lock();
+            handshake_done_ = false;
+            ssl_socket_ = engine_->createContext(transport_, static_cast<SslEngine::Handler*>(this));
+            ssl_socket_->setCaptureId(transport_->getCaptureId());
+            ssl_socket_->handshake();
+        }
+        void TlsTransport::onTransportClose(Transport &transport) {
+            if(handler_) {
+                handler_->onTransportClose(*this);
+            }
+            ssl_socket_ = nullptr;
+            handshake_done_ = false;
+        }
+        void TlsTransport::onTransportError(Transport &transport, Error &err) {
+            if(handler_) {
+                handler_->onTransportError(*this, err);
+            }
+        }
+        bool TlsTransport::onTransportEnd(Transport &transport) {
+            if(handler_) {
+                return handler_->onTransportEnd(*this);
+            }
+            return false;
+        }
+        void TlsTransport::onTransportData(Transport &transport, std::unique_ptr<char[]> data, size_t length) {
+            if(ssl_socket_) {
+                ssl_socket_->feedRead(std::move(data), length);
+            }
+        }
 
-                  },
-                  [this](SslEngine::SocketContext *socket_context, const char *buf, int size) -> void {
-                    // Read
-					  if (on_data_) {
-						  std::unique_ptr<char[]> ubuf(new char[size]);
-						  memcpy(ubuf.get(), buf, size);
-						  on_data_(*this, std::move(ubuf), size);
-					  }
-                  },
-                  [this](SslEngine::SocketContext *socket_context, int status) -> void {
-                      // Close
-                      transport_->disconnect();
-                      ssl_socket_ = nullptr;
-                  },
-                  [this](SslEngine::SocketContext *socket_context, Error &err) -> void {
-                      if(on_error_) {
-                          on_error_(*this, err);
-                      }
-                  }
-              );
-              ssl_socket_->handshake();
-            }, [this](Transport& transport) -> void {
-                if(on_close_) {
-                    on_close_(*this);
+        void TlsTransport::onSslHandshake(SslEngine::SocketContext *socket_context, int status) {
+            if(status == 1) {
+                handshake_done_ = true;
+                while(ssl_socket_ && !write_queue_.empty()) {
+                    ssl_socket_->write(std::move(write_queue_.front().first), write_queue_.front().second);
+                    write_queue_.pop_front();
                 }
-                ssl_socket_ = nullptr;
-            },
-            on_error_);
+            }
+            if(handler_) {
+                handler_->onTransportConnect(*this);
+            }
+        }
+        void TlsTransport::onSslRead(SslEngine::SocketContext *socket_context, const char *buf, int size) {
+            if(handler_) {
+                std::unique_ptr<char[]> ubuf(new char[size]);
+                memcpy(ubuf.get(), buf, size);
+                handler_->onTransportData(*this, std::move(ubuf), size);
+            }
         }
+        void TlsTransport::onSslClose(SslEngine::SocketContext *socket_context, int status) {
+            if(user_disconnect_) {
+                transport_->disconnect();
+            } else {
+                // close_notify from the peer, the reconnect policy of the inner transport applies
+                transport_->closeConnection();
+            }
+            ssl_socket_ = nullptr;
+            handshake_done_ = false;
+        }
+        void TlsTransport::onSslError(SslEngine::SocketContext *socket_context, Error &err) {
+            if(handler_) {
+                handler_->onTransportError(*this, err);
+            }
+        }
+
         void TlsTransport::reconnect() {
+            user_disconnect_ = false;
             transport_->reconnect();
         }
         void TlsTransport::disconnect() {
-            ssl_socket_->disconnect();
+            user_disconnect_ = true;
+            if(ssl_socket_) {
+                ssl_socket_->disconnect();
+            } else {
+                transport_->disconnect();
+            }
+        }
+        void TlsTransport::closeConnection() {
+            if(ssl_socket_) {
+                ssl_socket_->disconnect();
+            } else {
+                transport_->closeConnection();
+            }
         }
         void TlsTransport::cleanup() {
             transport_->cleanup();
-            on_connect_ = nullptr;
-            on_close_ = nullptr;
-        }
-        void TlsTransport::onData(const OnDataCallback_t &on_data) {
-            this->on_data_ = on_data;
+            handler_ = nullptr;
+            write_queue_.clear();
         }
-        void TlsTransport::onEnd(const OnEndCallback_t &on_end) {
-            on_end_ = on_end;
+        void TlsTransport::setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) {
+            transport_->setReconnectPolicy(policy, [this, on_state](Transport& transport, ReconnectState state, int attempt, uint64_t delay_ms) -> void {
+                if(on_state) {
+                    on_state(*this, state, attempt, delay_ms);
+                }
+                if(state == RECONNECT_GAVE_UP) {
+                    write_queue_.clear();
+                }
+            });
         }
         void TlsTransport::write(std::unique_ptr<char[]> data, size_t length) {
+            // kept here until the session is up, a connection lost during the handshake keeps them
+            if(!ssl_socket_ || !handshake_done_) {
+                write_queue_.push_back(std::make_pair(std::move(data), length));
+                return;
+            }
             this->ssl_socket_->write(std::move(data), length);
         }
+        void TlsTransport::pauseRead() {
+            transport_->pauseRead();
+        }
+        void TlsTransport::resumeRead() {
+            transport_->resumeRead();
+        }
+        void TlsTransport::compact() {
+            if(ssl_socket_) {
+                ssl_socket_->compact();
+            }
+        }
+        uint32_t TlsTransport::getCaptureId() const {
+            return transport_->getCaptureId();
+        }
     }
 }
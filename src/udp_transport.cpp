@@ -0,0 +1,433 @@
+/**
+ * @file	udp_transport.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/udp_transport.h>
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+
+#define JCU_TRANSPORT_UDP_BATCH
+#endif
+
+namespace jcu {
+    namespace transport {
+
+        class UdpTransportError : public Error {
+        public:
+            int code_;
+            std::string name_;
+            std::string what_;
+
+            UdpTransportError(const uvw::ErrorEvent &evt) {
+                const char *name = evt.name();
+                const char *what = evt.what();
+                if(name) name_ = name;
+                if(what) what_ = what;
+                code_ = evt.code();
+            }
+            UdpTransportError(int code) {
+                const char *name = uv_err_name(code);
+                const char *what = uv_strerror(code);
+                if(name) name_ = name;
+                if(what) what_ = what;
+                code_ = code;
+            }
+
+            const char *what() const override {
+                return what_.c_str();
+            }
+            const char *name() const override {
+                return name_.c_str();
+            }
+            int code() const override {
+                return code_;
+            }
+            explicit operator bool() const override {
+                return true;
+            }
+        };
+
+        static int resolveAddress(const std::string &ip, int port, bool ipv6, sockaddr_storage &addr) {
+            memset(&addr, 0, sizeof(addr));
+            if(ipv6) {
+                return uv_ip6_addr(ip.c_str(), port, reinterpret_cast<sockaddr_in6*>(&addr));
+            }
+            return uv_ip4_addr(ip.c_str(), port, reinterpret_cast<sockaddr_in*>(&addr));
+        }
+
+        /**
+         * 16 byte form of an address in which every notation of a host compares equal,
+         * IPv4 addresses become IPv4-mapped IPv6 ones.
+         */
+        static bool addressKey(const std::string &ip, unsigned char key[16]) {
+            memset(key, 0, 16);
+            if(ip.find(':') != std::string::npos) {
+                return uv_inet_pton(AF_INET6, ip.c_str(), key) == 0;
+            }
+            key[10] = 0xff;
+            key[11] = 0xff;
+            return uv_inet_pton(AF_INET, ip.c_str(), key + 12) == 0;
+        }
+
+#ifdef JCU_TRANSPORT_UDP_BATCH
+        struct UdpTransport::BatchSender {
+            enum {
+                MAX_BATCH = 64,
+                MAX_GSO_BYTES = 65000
+            };
+
+            int fd;
+            bool gso_supported;
+            sockaddr_storage remote_addr;
+            socklen_t remote_addr_len;
+
+            BatchSender() : fd(-1), gso_supported(false), remote_addr_len(0) {
+                memset(&remote_addr, 0, sizeof(remote_addr));
+            }
+
+            bool open(uvw::UDPHandle &handle, const sockaddr_storage &remote) {
+                uv_os_fd_t os_fd;
+                if(uv_fileno(reinterpret_cast<uv_handle_t*>(handle.raw()), &os_fd) != 0) {
+                    return false;
+                }
+                fd = os_fd;
+                remote_addr = remote;
+                remote_addr_len = (remote.ss_family == AF_INET6) ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+
+                int gso_size = 0;
+                socklen_t optlen = sizeof(gso_size);
+                gso_supported = (getsockopt(fd, SOL_UDP, UDP_SEGMENT, &gso_size, &optlen) == 0);
+                return true;
+            }
+
+            /**
+             * Leading datagrams that can go out as one GSO send: all the same size,
+             * except for the last one which may be shorter.
+             */
+            size_t gsoRun(const std::deque<std::pair<std::unique_ptr<char[]>, size_t>> &queue) const {
+                size_t segment = queue.front().second;
+                size_t total = 0;
+                size_t count = 0;
+                for(std::deque<std::pair<std::unique_ptr<char[]>, size_t>>::const_iterator iter = queue.begin();
+                    (iter != queue.end()) && (count < MAX_BATCH); ++iter) {
+                    if((iter->second > segment) || (total + iter->second > MAX_GSO_BYTES)) {
+                        break;
+                    }
+                    total += iter->second;
+                    count++;
+                    if(iter->second < segment) {
+                        break;
+                    }
+                }
+                return count;
+            }
+
+            /**
+             * Sends as much of the queue as the socket accepts without blocking.
+             * Datagrams left in the queue (EAGAIN or an error) go through libuv,
+             * which also reports the error.
+             */
+            void send(std::deque<std::pair<std::unique_ptr<char[]>, size_t>> &queue) {
+                struct iovec iov[MAX_BATCH];
+
+                while(!queue.empty()) {
+                    size_t run = gso_supported ? gsoRun(queue) : 0;
+
+                    if(run > 1) {
+                        char control[CMSG_SPACE(sizeof(uint16_t))];
+                        struct msghdr msg;
+                        memset(&msg, 0, sizeof(msg));
+                        memset(control, 0, sizeof(control));
+                        for(size_t i = 0; i < run; i++) {
+                            iov[i].iov_base = queue[i].first.get();
+                            iov[i].iov_len = queue[i].second;
+                        }
+                        msg.msg_name = &remote_addr;
+                        msg.msg_namelen = remote_addr_len;
+                        msg.msg_iov = iov;
+                        msg.msg_iovlen = run;
+                        msg.msg_control = control;
+                        msg.msg_controllen = sizeof(control);
+
+                        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+                        cmsg->cmsg_level = SOL_UDP;
+                        cmsg->cmsg_type = UDP_SEGMENT;
+                        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                        uint16_t segment = (uint16_t)queue.front().second;
+                        memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+
+                        ssize_t r;
+                        do {
+                            r = sendmsg(fd, &msg, 0);
+                        } while((r < 0) && (errno == EINTR));
+                        if(r >= 0) {
+                            queue.erase(queue.begin(), queue.begin() + run);
+                            continue;
+                        }
+                        if((errno == EINVAL) || (errno == EIO)) {
+                            // the device or the kernel refused segmentation offload
+                            gso_supported = false;
+                            continue;
+                        }
+                        // EAGAIN or an error of the datagrams themselves, left to libuv
+                        return;
+                    }
+
+                    struct mmsghdr msgs[MAX_BATCH];
+                    size_t count = std::min(queue.size(), (size_t)MAX_BATCH);
+                    memset(msgs, 0, sizeof(msgs[0]) * count);
+                    for(size_t i = 0; i < count; i++) {
+                        iov[i].iov_base = queue[i].first.get();
+                        iov[i].iov_len = queue[i].second;
+                        msgs[i].msg_hdr.msg_name = &remote_addr;
+                        msgs[i].msg_hdr.msg_namelen = remote_addr_len;
+                        msgs[i].msg_hdr.msg_iov = &iov[i];
+                        msgs[i].msg_hdr.msg_iovlen = 1;
+                    }
+
+                    int r;
+                    do {
+                        r = sendmmsg(fd, msgs, (unsigned int)count, 0);
+                    } while((r < 0) && (errno == EINTR));
+                    if(r < 0) {
+                        return;
+                    }
+                    queue.erase(queue.begin(), queue.begin() + r);
+                    if((size_t)r < count) {
+                        return;
+                    }
+                }
+            }
+        };
+#else
+        struct UdpTransport::BatchSender {
+        };
+#endif
+
+        std::shared_ptr<UdpTransport> UdpTransport::create(std::shared_ptr<uvw::Loop> loop) {
+            std::shared_ptr<UdpTransport> instance(new UdpTransport(loop));
+            instance->self_ = instance;
+            return instance;
+        }
+
+        UdpTransport::UdpTransport(std::shared_ptr<uvw::Loop> loop)
+            : Transport(loop), remote_port_(0), local_port_(0), ipv6_(false), read_paused_(false),
+              flush_(loop, [this]() -> void { flushWrites(); }) {
+            memset(&remote_addr_, 0, sizeof(remote_addr_));
+            memset(remote_key_, 0, sizeof(remote_key_));
+        }
+
+        UdpTransport::~UdpTransport() {
+            if(sock_handle_) {
+                sock_handle_->clear();
+                sock_handle_->close();
+            }
+        }
+
+        void UdpTransport::setRemote(const std::string& remote_ip, int remote_port) {
+            remote_ip_ = remote_ip;
+            remote_port_ = remote_port;
+        }
+
+        void UdpTransport::setLocal(const std::string& local_ip, int local_port) {
+            local_ip_ = local_ip;
+            local_port_ = local_port;
+        }
+
+        void UdpTransport::connect(Handler *handler) {
+            handler_ = handler;
+
+            reconnect();
+        }
+        void UdpTransport::reconnect() {
+            std::shared_ptr<UdpTransport> self = self_.lock();
+            if(sock_handle_) {
+                batch_sender_ = nullptr;
+                sock_handle_->clear();
+                sock_handle_->close();
+                sock_handle_ = nullptr;
+            }
+
+            ipv6_ = (remote_ip_.find(':') != std::string::npos);
+            std::string local_ip = local_ip_;
+            if(local_ip.empty()) {
+                local_ip = ipv6_ ? "::" : "0.0.0.0";
+            }
+
+            // resolved once, sends and the sender filter work on the binary addresses
+            sockaddr_storage local_addr;
+            int rc = resolveAddress(remote_ip_, remote_port_, ipv6_, remote_addr_);
+            if((rc == 0) && !addressKey(remote_ip_, remote_key_)) {
+                rc = UV_EINVAL;
+            }
+            if(rc == 0) {
+                rc = resolveAddress(local_ip, local_port_, ipv6_, local_addr);
+            }
+            if(rc != 0) {
+                UdpTransportError err(rc);
+                if(handler_) {
+                    handler_->onTransportError(*this, err);
+                }
+                return;
+            }
+
+            std::shared_ptr<uvw::UDPHandle> sock_handle = loop_->resource<uvw::UDPHandle>();
+            sock_handle->on<uvw::CloseEvent>([this](uvw::CloseEvent &evt, uvw::UDPHandle &handle) -> void {
+                // the handle no longer keeps this transport alive once closed
+                std::shared_ptr<UdpTransport> self = self_.lock();
+                handle.data(nullptr);
+                if(handler_) {
+                    handler_->onTransportClose(*this);
+                }
+            });
+            sock_handle->on<uvw::ErrorEvent>([this](uvw::ErrorEvent &evt, uvw::UDPHandle &handle) -> void {
+                UdpTransportError err(evt);
+                if(handler_) {
+                    handler_->onTransportError(*this, err);
+                }
+            });
+            sock_handle->on<uvw::UDPDataEvent>([this](uvw::UDPDataEvent &evt, uvw::UDPHandle &handle) -> void {
+                // only datagrams from the remote endpoint belong to this transport
+                unsigned char sender_key[sizeof(remote_key_)];
+                if((evt.sender.port != (unsigned int)remote_port_) || !addressKey(evt.sender.ip, sender_key) ||
+                    (memcmp(sender_key, remote_key_, sizeof(remote_key_)) != 0)) {
+                    return;
+                }
+                if(handler_) {
+                    handler_->onTransportData(*this, std::unique_ptr<char[]>(const_cast<char*>(evt.data.release())), evt.length);
+                }
+            });
+            sock_handle_ = sock_handle;
+
+            rc = uv_udp_bind(sock_handle->raw(), reinterpret_cast<const sockaddr*>(&local_addr), 0);
+            if(rc != 0) {
+                UdpTransportError err(rc);
+                if(handler_) {
+                    handler_->onTransportError(*this, err);
+                }
+                // never connected, onTransportClose ends the attempt and the datagrams stay queued
+                closeSocket();
+                return;
+            }
+            if(!read_paused_) {
+                startRecv();
+            }
+
+#ifdef JCU_TRANSPORT_UDP_BATCH
+            batch_sender_.reset(new BatchSender());
+            if(!batch_sender_->open(*sock_handle, remote_addr_)) {
+                batch_sender_ = nullptr;
+            }
+#endif
+
+            if(handler_) {
+                handler_->onTransportConnect(*this);
+            }
+
+            // datagrams written while no socket was open
+            if(sock_handle_ && !write_queue_.empty()) {
+                flush_.schedule();
+            }
+        }
+        void UdpTransport::disconnect() {
+            if(sock_handle_) {
+                flushWrites();
+                closeSocket();
+            }
+        }
+        void UdpTransport::closeSocket() {
+            if(!sock_handle_) {
+                return;
+            }
+            // the descriptor may be reused once closed, never send on it again
+            batch_sender_ = nullptr;
+            sock_handle_->data(self_.lock());
+            sock_handle_->close();
+            sock_handle_ = nullptr;
+        }
+        void UdpTransport::cleanup() {
+            disconnect();
+            handler_ = nullptr;
+            write_queue_.clear();
+        }
+        void UdpTransport::setReconnectPolicy(const ReconnectPolicy& policy, const OnReconnectStateCallback_t& on_state) {
+        }
+        void UdpTransport::write(std::unique_ptr<char[]> data, size_t length) {
+            write_queue_.push_back(std::make_pair(std::move(data), length));
+            // without a socket the datagrams wait for reconnect()
+            if(sock_handle_) {
+                flush_.schedule();
+            }
+        }
+
+        void UdpTransport::pauseRead() {
+            if(read_paused_) {
+                return;
+            }
+            read_paused_ = true;
+            if(sock_handle_) {
+                sock_handle_->stop();
+            }
+        }
+        void UdpTransport::resumeRead() {
+            if(!read_paused_) {
+                return;
+            }
+            read_paused_ = false;
+            if(sock_handle_) {
+                startRecv();
+            }
+        }
+        void UdpTransport::startRecv() {
+            if(ipv6_) {
+                sock_handle_->recv<uvw::IPv6>();
+            } else {
+                sock_handle_->recv<uvw::IPv4>();
+            }
+        }
+
+        void UdpTransport::flushWrites() {
+            std::shared_ptr<UdpTransport> self = self_.lock();
+
+            flush_.cancel();
+            if(!sock_handle_) {
+                return;
+            }
+
+#ifdef JCU_TRANSPORT_UDP_BATCH
+            // datagrams still in libuv's send queue go first, the batch path must not overtake them
+            if(batch_sender_ && (sock_handle_->sendQueueCount() == 0)) {
+                batch_sender_->send(write_queue_);
+            }
+#endif
+
+            // whatever the socket did not take right away goes through libuv's send queue
+            while(!write_queue_.empty()) {
+                std::pair<std::unique_ptr<char[]>, size_t> &front = write_queue_.front();
+                sock_handle_->send(reinterpret_cast<const sockaddr&>(remote_addr_), std::move(front.first), (unsigned int)front.second);
+                write_queue_.pop_front();
+            }
+        }
+    }
+}
@@ -0,0 +1,178 @@
+/**
+ * @file	memory_transport.h
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#ifndef __JCU_TRANSPORT_TESTS_MEMORY_TRANSPORT_H__
+#define __JCU_TRANSPORT_TESTS_MEMORY_TRANSPORT_H__
+
+#include <jcu/transport/transport.h>
+
+#include <uvw/idle.hpp>
+
+#include <deque>
+#include <utility>
+
+namespace jcu {
+    namespace transport {
+        /**
+         * One end of an in-process connection.
+         * Writes are delivered to the other end of the pair from the loop, one loop
+         * iteration later, in order and with the chunking of the writes. Closing either
+         * end closes both, after the data already written.
+         */
+        class MemoryTransport : public Transport {
+        private:
+            enum EventType {
+                EVENT_CONNECT,
+                EVENT_DATA,
+                EVENT_CLOSE
+            };
+            struct Event {
+                EventType type;
+                std::unique_ptr<char[]> data;
+                size_t length;
+            };
+
+            std::weak_ptr<MemoryTransport> self_;
+            std::weak_ptr<MemoryTransport> peer_;
+
+            std::shared_ptr<uvw::IdleHandle> pump_;
+            bool pump_active_;
+            std::deque<Event> inbox_;
+
+            bool connected_;
+            bool closing_;
+            bool read_paused_;
+
+            MemoryTransport(std::shared_ptr<uvw::Loop> loop)
+                : Transport(loop), pump_active_(false), connected_(false), closing_(false), read_paused_(false) {
+                pump_ = loop_->resource<uvw::IdleHandle>();
+                pump_->on<uvw::IdleEvent>([this](uvw::IdleEvent &evt, uvw::IdleHandle &handle) -> void {
+                    deliver();
+                });
+            }
+
+            void post(EventType type, std::unique_ptr<char[]> data, size_t length) {
+                Event event;
+                event.type = type;
+                event.data = std::move(data);
+                event.length = length;
+                inbox_.push_back(std::move(event));
+                if(!pump_active_ && !read_paused_) {
+                    pump_active_ = true;
+                    pump_->start();
+                }
+            }
+
+            void deliver() {
+                std::shared_ptr<MemoryTransport> self = self_.lock();
+                if(inbox_.empty() || read_paused_) {
+                    // stopped one iteration late, so the loop does not block on the poll
+                    // of the iteration that delivered the last event
+                    pump_active_ = false;
+                    pump_->stop();
+                    return;
+                }
+                // events posted meanwhile wait for the next iteration
+                size_t count = inbox_.size();
+                while(count-- && !inbox_.empty() && !read_paused_) {
+                    Event event = std::move(inbox_.front());
+                    inbox_.pop_front();
+                    switch(event.type) {
+                        case EVENT_CONNECT:
+                            connected_ = true;
+                            if(handler_) {
+                                handler_->onTransportConnect(*this);
+                            }
+                            break;
+                        case EVENT_DATA:
+                            if(connected_ && handler_) {
+                                handler_->onTransportData(*this, std::move(event.data), event.length);
+                            }
+                            break;
+                        case EVENT_CLOSE:
+                            if(connected_) {
+                                connected_ = false;
+                                if(handler_) {
+                                    handler_->onTransportClose(*this);
+                                }
+                            }
+                            break;
+                    }
+                }
+            }
+
+        public:
+            static std::pair<std::shared_ptr<MemoryTransport>, std::shared_ptr<MemoryTransport>> createPair(std::shared_ptr<uvw::Loop> loop) {
+                std::shared_ptr<MemoryTransport> first(new MemoryTransport(loop));
+                std::shared_ptr<MemoryTransport> second(new MemoryTransport(loop));
+                first->self_ = first;
+                second->self_ = second;
+                first->peer_ = second;
+                second->peer_ = first;
+                return std::make_pair(first, second);
+            }
+
+            virtual ~MemoryTransport() {
+                pump_->close();
+            }
+
+            using Transport::connect;
+            void connect(Handler *handler) override {
+                handler_ = handler;
+                post(EVENT_CONNECT, nullptr, 0);
+            }
+            // a pair is connected only once
+            void reconnect() override {
+            }
+            void disconnect() override {
+                if(closing_) {
+                    return;
+                }
+                closing_ = true;
+                post(EVENT_CLOSE, nullptr, 0);
+                std::shared_ptr<MemoryTransport> peer = peer_.lock();
+                if(peer && !peer->closing_) {
+                    peer->closing_ = true;
+                    peer->post(EVENT_CLOSE, nullptr, 0);
+                }
+            }
+            void cleanup() override {
+                disconnect();
+                handler_ = nullptr;
+            }
+
+            void setReconnectPolicy(const ReconnectPolicy&, const OnReconnectStateCallback_t&) override {
+            }
+
+            void write(std::unique_ptr<char[]> data, size_t length) override {
+                std::shared_ptr<MemoryTransport> peer = peer_.lock();
+                if(closing_ || !peer) {
+                    return;
+                }
+                peer->post(EVENT_DATA, std::move(data), length);
+            }
+
+            void pauseRead() override {
+                read_paused_ = true;
+            }
+            void resumeRead() override {
+                if(!read_paused_) {
+                    return;
+                }
+                read_paused_ = false;
+                if(!inbox_.empty() && !pump_active_) {
+                    pump_active_ = true;
+                    pump_->start();
+                }
+            }
+        };
+    }
+}
+
+#endif //__JCU_TRANSPORT_TESTS_MEMORY_TRANSPORT_H__
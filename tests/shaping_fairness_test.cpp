@@ -0,0 +1,117 @@
+/**
+ * @file	shaping_fairness_test.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/shaped_transport.h>
+
+#include <uvw/loop.hpp>
+#include <uvw/timer.hpp>
+
+#include <stdio.h>
+
+#include <vector>
+
+using namespace jcu::transport;
+
+namespace {
+    const size_t TRANSPORT_COUNT = 3;
+    const uint64_t GROUP_RATE = 1024 * 1024;
+    const size_t CHUNK_SIZE = 4096;
+    // far more than the group lets through while the test runs
+    const size_t BACKLOG_CHUNKS = 2048;
+    const uint64_t RUN_MS = 1500;
+
+    /**
+     * Counts what the shaper lets through
+     */
+    class CountingTransport : public Transport {
+    public:
+        uint64_t bytes_written_;
+
+        CountingTransport(std::shared_ptr<uvw::Loop> loop) : Transport(loop), bytes_written_(0) {}
+
+        using Transport::connect;
+        void connect(Handler *handler) override {
+            handler_ = handler;
+        }
+        void reconnect() override {}
+        void disconnect() override {}
+        void cleanup() override {
+            handler_ = nullptr;
+        }
+        void setReconnectPolicy(const ReconnectPolicy&, const OnReconnectStateCallback_t&) override {}
+        void write(std::unique_ptr<char[]>, size_t length) override {
+            bytes_written_ += length;
+        }
+        void pauseRead() override {}
+        void resumeRead() override {}
+    };
+}
+
+int main() {
+    std::shared_ptr<uvw::Loop> loop = uvw::Loop::create();
+    int result = 0;
+    {
+        // the group is the bottleneck, the transports have no limit of their own
+        std::shared_ptr<ShapingGroup> group = ShapingGroup::create();
+        group->setWriteRate(GROUP_RATE, CHUNK_SIZE);
+
+        std::vector<std::shared_ptr<CountingTransport>> counters;
+        std::vector<std::shared_ptr<ShapedTransport>> transports;
+        for(size_t i = 0; i < TRANSPORT_COUNT; i++) {
+            counters.push_back(std::make_shared<CountingTransport>(loop));
+            transports.push_back(ShapedTransport::create(loop, counters.back(), group));
+        }
+        for(size_t chunk = 0; chunk < BACKLOG_CHUNKS; chunk++) {
+            for(size_t i = 0; i < TRANSPORT_COUNT; i++) {
+                transports[i]->write(std::unique_ptr<char[]>(new char[CHUNK_SIZE]), CHUNK_SIZE);
+            }
+        }
+
+        std::shared_ptr<uvw::TimerHandle> timer = loop->resource<uvw::TimerHandle>();
+        timer->on<uvw::TimerEvent>([&transports](uvw::TimerEvent &evt, uvw::TimerHandle &handle) -> void {
+            // drops the backlogs, the scheduler has nothing left to wait for
+            for(size_t i = 0; i < transports.size(); i++) {
+                transports[i]->cleanup();
+            }
+            handle.close();
+        });
+        timer->start(uvw::TimerHandle::Time(RUN_MS), uvw::TimerHandle::Time(0));
+
+        loop->run();
+
+        uint64_t total = 0;
+        for(size_t i = 0; i < TRANSPORT_COUNT; i++) {
+            total += counters[i]->bytes_written_;
+        }
+        double fair_share = (double)total / TRANSPORT_COUNT;
+        for(size_t i = 0; i < TRANSPORT_COUNT; i++) {
+            double share = counters[i]->bytes_written_ / fair_share;
+            printf("transport %u: %llu bytes, %.2f of a fair share\n", (unsigned int)i,
+                   (unsigned long long)counters[i]->bytes_written_, share);
+            if((share < 0.8) || (share > 1.2)) {
+                result = 1;
+            }
+        }
+        // the group limit must hold as well (burst and one chunk of overdraw aside)
+        if(total > GROUP_RATE * RUN_MS / 1000 + 2 * CHUNK_SIZE + CHUNK_SIZE * TRANSPORT_COUNT) {
+            printf("%llu bytes sent, above the group rate\n", (unsigned long long)total);
+            result = 1;
+        }
+        if(total == 0) {
+            result = 1;
+        }
+
+        transports.clear();
+    }
+    loop->run();
+    loop->close();
+
+    printf("%s\n", result ? "FAILED" : "OK");
+    return result;
+}
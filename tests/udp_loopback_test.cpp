@@ -0,0 +1,171 @@
+/**
+ * @file	udp_loopback_test.cpp
+ * @author	agent <agent@local>
+ * @date	2026/10/19
+ * @copyright Copyright (C) 2026 jc-lab.\n
+ *            This software may be modified and distributed under the terms
+ *            of the Apache License 2.0.  See the LICENSE file for details.
+ */
+
+#include <jcu/transport/udp_transport.h>
+
+#include <uvw/loop.hpp>
+#include <uvw/timer.hpp>
+#include <uvw/udp.hpp>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+using namespace jcu::transport;
+
+namespace {
+    // datagrams sent in total, in runs the batch sender can segment
+    const size_t BURST_COUNT = 200;
+    // datagrams in flight at once, little enough for the default receive buffers
+    // (a datagram costs the socket well over its own size in buffer space)
+    const size_t WINDOW = 32;
+    const int SERVER_RCVBUF = 1024 * 1024;
+
+    size_t datagramSize(uint32_t seq) {
+        // equal sized runs of 16 closed by a shorter one, then a few oversized ones
+        if(seq >= BURST_COUNT - 8) {
+            return 1200 + seq;
+        }
+        return ((seq % 17) == 16) ? 100 : 1000;
+    }
+
+    std::unique_ptr<char[]> makeDatagram(uint32_t seq, size_t length) {
+        std::unique_ptr<char[]> data(new char[length]);
+        memset(data.get(), (int)(seq & 0xff), length);
+        memcpy(data.get(), &seq, sizeof(seq));
+        return data;
+    }
+
+    class LoopbackClient : public Transport::Handler {
+    public:
+        std::shared_ptr<UdpTransport> transport_;
+        std::shared_ptr<uvw::UDPHandle> server_;
+        std::shared_ptr<uvw::TimerHandle> timeout_;
+
+        std::vector<bool> received_;
+        size_t received_count_;
+        uint32_t next_seq_;
+        int errors_;
+        bool connected_;
+        bool closed_;
+
+        LoopbackClient() : received_count_(0), next_seq_(1), errors_(0), connected_(false), closed_(false) {
+            // seq 0 is written before connect(), 1..BURST_COUNT after it
+            received_.resize(BURST_COUNT + 1, false);
+        }
+
+        void finish() {
+            server_->close();
+            timeout_->close();
+        }
+
+        void sendNext(Transport &transport) {
+            if(next_seq_ > BURST_COUNT) {
+                return;
+            }
+            size_t length = datagramSize(next_seq_);
+            transport.write(makeDatagram(next_seq_, length), length);
+            next_seq_++;
+        }
+
+        void onTransportConnect(Transport &transport) override {
+            connected_ = true;
+            // the first window goes out within one loop iteration, each echo releases the next datagram
+            for(size_t i = 0; i < WINDOW; i++) {
+                sendNext(transport);
+            }
+        }
+        void onTransportClose(Transport &transport) override {
+            closed_ = true;
+            // nothing may reach the closed descriptor, the datagram waits for reconnect()
+            transport.write(makeDatagram(0, 16), 16);
+            finish();
+        }
+        void onTransportError(Transport &transport, Error &err) override {
+            fprintf(stderr, "transport error: %s %s\n", err.name(), err.what());
+            errors_++;
+        }
+        void onTransportData(Transport &transport, std::unique_ptr<char[]> data, size_t length) override {
+            uint32_t seq;
+            if(length < sizeof(seq)) {
+                errors_++;
+                return;
+            }
+            memcpy(&seq, data.get(), sizeof(seq));
+            size_t expected = (seq == 0) ? 64 : datagramSize(seq);
+            if((seq > BURST_COUNT) || (length != expected) || received_[seq]) {
+                fprintf(stderr, "unexpected datagram seq=%u length=%u\n", seq, (unsigned int)length);
+                errors_++;
+                return;
+            }
+            for(size_t i = sizeof(seq); i < length; i++) {
+                if(data[i] != (char)(seq & 0xff)) {
+                    fprintf(stderr, "corrupted datagram seq=%u\n", seq);
+                    errors_++;
+                    return;
+                }
+            }
+            received_[seq] = true;
+            received_count_++;
+            if(seq != 0) {
+                sendNext(transport);
+            }
+            if(received_count_ == received_.size()) {
+                transport_->disconnect();
+            }
+        }
+    };
+}
+
+int main() {
+    std::shared_ptr<uvw::Loop> loop = uvw::Loop::create();
+    LoopbackClient client;
+
+    client.server_ = loop->resource<uvw::UDPHandle>();
+    client.server_->on<uvw::UDPDataEvent>([](uvw::UDPDataEvent &evt, uvw::UDPHandle &handle) -> void {
+        std::unique_ptr<char[]> echo(new char[evt.length]);
+        memcpy(echo.get(), evt.data.get(), evt.length);
+        handle.send(evt.sender.ip, evt.sender.port, std::move(echo), (unsigned int)evt.length);
+    });
+    client.server_->bind("127.0.0.1", 0);
+    client.server_->recvBufferSize(SERVER_RCVBUF);
+    client.server_->recv();
+    uvw::Addr server_addr = client.server_->sock();
+
+    client.timeout_ = loop->resource<uvw::TimerHandle>();
+    client.timeout_->on<uvw::TimerEvent>([&client](uvw::TimerEvent &evt, uvw::TimerHandle &handle) -> void {
+        fprintf(stderr, "timed out with %u of %u datagrams echoed\n",
+                (unsigned int)client.received_count_, (unsigned int)client.received_.size());
+        client.transport_->cleanup();
+        client.finish();
+    });
+    client.timeout_->start(uvw::TimerHandle::Time(10000), uvw::TimerHandle::Time(0));
+
+    client.transport_ = UdpTransport::create(loop);
+    client.transport_->setRemote("127.0.0.1", server_addr.port);
+    client.transport_->setLocal("127.0.0.1", 0);
+
+    // queued until connect() opens the socket
+    client.transport_->write(makeDatagram(0, 64), 64);
+    client.transport_->connect(&client);
+
+    loop->run();
+
+    client.transport_->cleanup();
+    client.transport_ = nullptr;
+    loop->close();
+
+    if(!client.connected_ || !client.closed_ || client.errors_ || (client.received_count_ != client.received_.size())) {
+        fprintf(stderr, "FAILED\n");
+        return 1;
+    }
+    printf("OK %u datagrams echoed over loopback\n", (unsigned int)client.received_count_);
+    return 0;
+}